@@ -2331,6 +2331,41 @@ public:
   TUSAS_CUDA_CALLABLE_MEMBER virtual void computeElemData( const double x[BASIS_NODES_PER_ELEM], 
 						   const double y[BASIS_NODES_PER_ELEM],  
 						   const double z[BASIS_NODES_PER_ELEM]) {};
+  /// Evaluate u and uold at Gauss point gp with the element geometry taken from a cache.
+  /** The caller sets jac, wt, xx, yy, zz, dphidx, dphidy and dphidz first; dxidx ... dztadz are not set on this path. */
+  TUSAS_CUDA_CALLABLE_MEMBER void getBasisCached(const int gp,
+						 const int n, ///< number of nodes in the element
+						 const double u[BASIS_NODES_PER_ELEM],
+						 const double uold[BASIS_NODES_PER_ELEM]) {
+    uu=0.0;
+    uuold=0.0;
+    uuoldold=0.0;
+    dudx=0.0;
+    dudy=0.0;
+    dudz=0.0;
+    duolddx = 0.;
+    duolddy = 0.;
+    duolddz = 0.;
+    duoldolddx = 0.;
+    duoldolddy = 0.;
+    duoldolddz = 0.;
+    for (int i=0; i < n; i++) {
+      phi[i]=phinew[gp][i];
+      if( u ){
+	uu += u[i] * phi[i];
+	dudx += u[i] * dphidx[i];
+	dudy += u[i] * dphidy[i];
+	dudz += u[i] * dphidz[i];
+      }
+      if( uold ){
+	uuold += uold[i] * phi[i];
+	duolddx += uold[i] * dphidx[i];
+	duolddy += uold[i] * dphidy[i];
+	duolddz += uold[i] * dphidz[i];
+      }
+    }
+    return;
+  }
 
   
     /// Access number of Gauss points.
@@ -13,9 +13,26 @@
 #include <Epetra_MapColoring.h>
 #include <Epetra_Util.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//cn isorropia coloring distance; the cache hash covers it and the cache format, so changing
+//cn either makes later runs recolor instead of reading colorings that no longer apply
+#define ELEM_COLOR_DISTANCE "1"
+#define ELEM_COLOR_CACHE_VERSION 2
+
 elem_color::elem_color(const Teuchos::RCP<const Epetra_Comm>& comm, 
 		       Mesh *mesh,
-		       bool dorestart):  
+		       bool dorestart,
+		       bool docontiguous,
+		       const std::string cachedir):  
   comm_(comm),
   mesh_(mesh)
 {
@@ -28,15 +45,53 @@ elem_color::elem_color(const Teuchos::RCP<const Epetra_Comm>& comm,
 
   //dorestart = false;
 
+  //cn the restart file holds colors in the renumbered elem order, which we cannot
+  //cn recover from the original mesh; recolor instead
+  if(docontiguous) dorestart = false;
+
+  //cn the coloring only depends on the local mesh, so it can be reused by later runs on the
+  //cn same mesh and decomposition; every proc has to hit, since the colorer is collective
+  std::string cfile;
+  unsigned long long hash = 0;
+  int hit = 0;
+  if(!dorestart && !cachedir.empty()){
+    hash = mesh_hash();
+    std::ostringstream name;
+    name<<cachedir<<"/color."<<std::hex<<std::setw(16)<<std::setfill('0')<<hash
+	<<"."<<std::dec<<comm_->NumProc()<<"."<<comm_->MyPID();
+    cfile = name.str();
+    int myhit = read_cache(cfile, hash) ? 1 : 0;
+    comm_->MinAll(&myhit, &hit, (int)1);
+  }
 
   if(dorestart){
     restart();
+  } else if(0 < hit){
+    init_mesh_data();
+    if( 0 == comm_->MyPID() )
+      std::cout<<std::endl<<"elem_color: read "<<num_color_<<" colors from cache "<<cachedir<<std::endl<<std::endl;
   } else {
     mesh_->compute_nodal_patch_overlap();
     compute_graph();
     create_colorer();
     init_mesh_data();
+    if(!cachedir.empty()){
+      //cn proc 0 makes the directory and reports once; a run without a cache is still a good run
+      int ok = 1;
+      if( 0 == comm_->MyPID() ){
+	struct stat st;
+	if( 0 != mkdir(cachedir.c_str(), 0755)
+	    && !( EEXIST == errno && 0 == stat(cachedir.c_str(), &st) && S_ISDIR(st.st_mode) ) ){
+	  std::cout<<"elem_color: could not create cache directory "<<cachedir<<": "<<std::strerror(errno)
+		   <<"; colorings are not cached"<<std::endl;
+	  ok = 0;
+	}
+      }
+      comm_->Broadcast(&ok, 1, 0);
+      if( 0 < ok ) write_cache(cfile, hash);
+    }
   }
+  if(docontiguous) renumber_contiguous();
 }
 
 elem_color::~elem_color()
@@ -78,11 +133,12 @@ void elem_color::compute_graph()
     //int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
     for (int ne=0; ne < mesh_->get_num_elem_in_blk(blk); ne++) {
       int row = mesh_->get_global_elem_id(ne);
-      std::vector<int> col = mesh_->get_elem_connect(ne);
+      const mesh_span col = mesh_->get_elem_connect(ne);
 //       std::cout<<row<<" : ";
 //       for(int i = 0; i<col.size(); i++) std::cout<<col[i]<<" ";
 //       std::cout<<std::endl;
-      graph_->InsertGlobalIndices(row, (int)(col.size()), &col[0]);
+      //cn Epetra copies the indices, it just is not const correct
+      graph_->InsertGlobalIndices(row, (int)(col.size()), const_cast<int*>(col.data()));
     }
   }
   insert_off_proc_elems();
@@ -108,7 +164,7 @@ void elem_color::create_colorer()
   //   we need a distance-1 coloring
 
   Teuchos::ParameterList paramList;
-  paramList.set("DISTANCE","1","");
+  paramList.set("DISTANCE",ELEM_COLOR_DISTANCE,"");
 
   //cn this call is very expensive......it seems that it might be mpi-only and not threaded in any way
   Teuchos::RCP<Isorropia::Epetra::Colorer> elem_colorer_;
@@ -234,7 +290,7 @@ void elem_color::insert_off_proc_elems(){
   for(int i = 0; i < rep_shared_node_map_->NumMyElements (); i++){
     const int rsgid = rep_shared_node_map_->GID(i);
     const int ogid = overlap_map_->LID(rsgid);
-    std::vector<int> mypatch;
+    mesh_span mypatch;
     if(ogid != -1){
       mypatch = mesh_->get_nodal_patch_overlap(ogid);
     }
@@ -420,3 +476,123 @@ void elem_color::restart(){
   std::cout<<std::endl<<"elem_color::restart() ended on proc "<<mypid<<std::endl<<std::endl;
   //exit(0);
 }
+
+unsigned long long elem_color::mesh_hash(){
+
+  //cn 64 bit fnv-1a over everything the coloring depends on; local ids are positions in
+  //cn elem_num_map, so renumbering or repartitioning changes the hash too
+
+  unsigned long long hash = 14695981039346656037ULL;
+  auto add = [&hash](const int v){
+    for(int b = 0; b < (int)sizeof(int); b++){
+      hash ^= (unsigned long long)((v >> 8*b) & 0xff);
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  add(ELEM_COLOR_CACHE_VERSION);
+  for(const char *c = ELEM_COLOR_DISTANCE; *c; c++) add(*c);
+  add(comm_->NumProc());
+  add(comm_->MyPID());
+  add(mesh_->get_num_elem());
+  for(int blk = 0, ne = 0; blk < mesh_->get_num_elem_blks(); blk++){
+    const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
+    add(n_nodes_per_elem);
+    for(int e = 0; e < mesh_->get_num_elem_in_blk(blk); e++, ne++){
+      add(mesh_->get_global_elem_id(ne));
+      for(int k = 0; k < n_nodes_per_elem; k++) add(mesh_->get_global_node_id(mesh_->get_node_id(blk, e, k)));
+    }
+  }
+  return hash;
+}
+
+bool elem_color::read_cache(const std::string cfile, const unsigned long long hash){
+
+  const int num_elem = mesh_->get_num_elem();
+
+  char magic[8];
+  int header[4];
+  unsigned long long fhash = 0;
+
+  std::ifstream infile(cfile.c_str(), std::ios::in | std::ios::binary);
+  infile.read(magic, sizeof(magic));
+  infile.read((char*)header, sizeof(header));
+  infile.read((char*)&fhash, sizeof(fhash));
+  if( !infile || 0 != std::string(magic, 8).compare("TUSASEC1") || hash != fhash
+      || comm_->NumProc() != header[0] || comm_->MyPID() != header[1] || num_elem != header[2] || 0 > header[3] )
+    return false;
+
+  std::vector<int> colors(num_elem);
+  infile.read((char*)colors.data(), num_elem*sizeof(int));
+  if( !infile ) return false;
+
+  num_color_ = header[3];
+  elem_LIDS_.assign(num_color_, std::vector<int>());
+  for(int i = 0; i < num_elem; i++){
+    if( 0 > colors[i] || num_color_ <= colors[i] ) return false;
+    elem_LIDS_[colors[i]].push_back(i);
+  }
+  return true;
+}
+
+void elem_color::write_cache(const std::string cfile, const unsigned long long hash){
+
+  //cn written to a temporary name and renamed, so concurrent jobs never read a partial file
+
+  const int num_elem = mesh_->get_num_elem();
+  std::vector<int> colors(num_elem, 0);
+  for(int c = 0; c < num_color_; c++)
+    for(int i = 0; i < elem_LIDS_[c].size(); i++) colors[elem_LIDS_[c][i]] = c;
+
+  const std::string tfile = cfile+".tmp."+std::to_string(getpid());
+
+  const char magic[8] = {'T','U','S','A','S','E','C','1'};
+  int header[4] = {comm_->NumProc(), comm_->MyPID(), num_elem, num_color_};
+
+  std::ofstream outfile(tfile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  outfile.write(magic, sizeof(magic));
+  outfile.write((const char*)header, sizeof(header));
+  outfile.write((const char*)&hash, sizeof(hash));
+  outfile.write((const char*)colors.data(), num_elem*sizeof(int));
+  outfile.close();
+
+  //cn a failed cache write only costs the next run a recoloring
+  if( !outfile || 0 != std::rename(tfile.c_str(), cfile.c_str()) ){
+    std::cout<<"elem_color: could not write cache file "<<cfile<<std::endl;
+    std::remove(tfile.c_str());
+  }
+}
+
+void elem_color::renumber_contiguous(){
+
+  //cn elems are stored color by color, keeping their current (eg space filling curve)
+  //cn order within a color; elem_LIDS_[c] becomes the range
+  //cn [color_begin_[c], color_begin_[c+1])
+
+  int mypid = comm_->MyPID();
+
+  if( 1 < mesh_->get_num_elem_blks() ){
+    if( 0 == mypid )
+      std::cout<<std::endl<<"elem_color::renumber_contiguous() requires one element block; skipping."<<std::endl<<std::endl;
+    return;
+  }
+
+  const int num_elem = mesh_->get_num_elem();
+  std::vector<int> e2o;
+  e2o.reserve(num_elem);
+  color_begin_.assign(num_color_ + 1, 0);
+  for(int c = 0; c < num_color_; c++){
+    color_begin_[c] = e2o.size();
+    std::sort(elem_LIDS_[c].begin(), elem_LIDS_[c].end());
+    e2o.insert(e2o.end(), elem_LIDS_[c].begin(), elem_LIDS_[c].end());
+  }
+  color_begin_[num_color_] = e2o.size();
+
+  mesh_->permute_elems(e2o);
+
+  for(int c = 0; c < num_color_; c++)
+    for(int i = 0; i < elem_LIDS_[c].size(); i++) elem_LIDS_[c][i] = color_begin_[c] + i;
+
+  if( 0 == mypid )
+    std::cout<<std::endl<<"elem_color::renumber_contiguous() ended."<<std::endl<<std::endl;
+}
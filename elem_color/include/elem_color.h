@@ -38,7 +38,9 @@ public:
   /// Constructor
   elem_color(const Teuchos::RCP<const Epetra_Comm>& comm,   ///< MPI communicator
 	     Mesh *mesh, ///< mesh object
-	     bool dorestart = false ///< do restart
+	     bool dorestart = false, ///< do restart
+	     bool docontiguous = false, ///< renumber elements so each color is a contiguous range
+	     const std::string cachedir = "" ///< directory of cached colorings, empty for none
 	     );
   ///Destructor
   ~elem_color();
@@ -50,6 +52,10 @@ public:
   std::vector< std::vector< int > > get_colors(){return elem_LIDS_;}
   /// Return the number of colors.
   int get_num_color(){return num_color_;}
+  /// Return the first local element id of the i-th color, or -1 if colors are not contiguous.
+  /** Color i occupies [get_color_begin(i), get_color_begin(i+1)). */
+  int get_color_begin(const int i ///<color index
+		      ){return color_begin_.empty() ? -1 : color_begin_[i];}
   /// Output element color to exodus file.
   void update_mesh_data();
 
@@ -79,6 +85,16 @@ private:
   std::vector<int> color_list_;
   /// Populate elem_LIDS_
   void restart();
+  /// Hash of the local mesh: proc count, rank, elem global ids and their node global ids.
+  unsigned long long mesh_hash();
+  /// Populate elem_LIDS_ from the cache file cfile; return false if it is missing or does not match.
+  bool read_cache(const std::string cfile, const unsigned long long hash);
+  /// Write elem_LIDS_ to the cache file cfile.
+  void write_cache(const std::string cfile, const unsigned long long hash);
+  /// Renumber mesh elements so each color is a contiguous range of local ids.
+  void renumber_contiguous();
+  /// First local element id of each color, size num_color_+1; empty if colors are not contiguous.
+  std::vector<int> color_begin_;
 
   //Teuchos::RCP<Teuchos::Time> ts_time_elemadj;
   Teuchos::RCP<Teuchos::Time> ts_time_color;
@@ -298,7 +298,7 @@ void error_estimator::estimate_gradient(const double * uvec ){
 
     int row = 0;
 
-    std::vector<int> n_patch(mesh_->get_nodal_patch_overlap(nn));
+    const mesh_span n_patch = mesh_->get_nodal_patch_overlap(nn);
 
     for(int ne = 0; ne < num_elem_in_patch; ne++){
 
@@ -68,6 +68,41 @@ void readParametersFromFile(    int argc, char *argv[], Teuchos::ParameterList &
 
   paramList.set(TusasexaConstitNameString,(bool)false,TusasexaConstitDocString);
 
+  paramList.set(TusasexplicitNameString,"none",TusasexplicitDocString);
+
+  paramList.set(TusassubcycleNameString,"{}",TusassubcycleDocString);
+
+  paramList.set(TusasdecompmethodNameString,"nemslice",TusasdecompmethodDocString);
+
+  paramList.set(TusasrenumberNameString,"none",TusasrenumberDocString);
+
+  paramList.set(TusascolorcontiguousNameString,(bool)false,TusascolorcontiguousDocString);
+  paramList.set(TusascolorcacheNameString,"",TusascolorcacheDocString);
+
+  paramList.set(TusascompactmeshNameString,(bool)false,TusascompactmeshDocString);
+
+  paramList.set(TusasgeometrycacheNameString,(bool)false,TusasgeometrycacheDocString);
+  paramList.set(TusasasyncoutputNameString,(bool)false,TusasasyncoutputDocString);
+  paramList.set(TusasglobaloutputNameString,(bool)false,TusasglobaloutputDocString);
+  paramList.set(TusasoutputfloatNameString,(bool)false,TusasoutputfloatDocString);
+  paramList.set(TusasoutputcompressionNameString,(int)0,TusasoutputcompressionDocString);
+  paramList.set(TusasoutputdigitsNameString,"{}",TusasoutputdigitsDocString);
+  paramList.set(TusasrestartnumprocNameString,(int)0,TusasrestartnumprocDocString);
+  paramList.set(TusasinsituNameString,"{}",TusasinsituDocString);
+  paramList.set(TusasinsitufreqNameString,(int)1,TusasinsitufreqDocString);
+  paramList.set(TusasinsitubinsNameString,(int)0,TusasinsitubinsDocString);
+  paramList.set(TusasinsituminNameString,(double)0.,TusasinsituminDocString);
+  paramList.set(TusasinsitumaxNameString,(double)1.,TusasinsitumaxDocString);
+  paramList.set(TusasregionfreqNameString,(int)0,TusasregionfreqDocString);
+  paramList.set(TusasregionboxNameString,"{}",TusasregionboxDocString);
+  paramList.set(TusasregionnodesetNameString,(int)-1,TusasregionnodesetDocString);
+  paramList.set(TusasregionstrideNameString,(int)1,TusasregionstrideDocString);
+  paramList.set(TusasregionfieldNameString,(int)-1,TusasregionfieldDocString);
+  paramList.set(TusasregionwindowNameString,"{0.,1.}",TusasregionwindowDocString);
+  paramList.set(TusascheckpointfreqNameString,(int)0,TusascheckpointfreqDocString);
+  paramList.set(TusascheckpointwalltimeNameString,(double)0.,TusascheckpointwalltimeDocString);
+  paramList.set(TusasrestartcheckpointNameString,(bool)false,TusasrestartcheckpointDocString);
+
   //ML parameters for ML and MueLu
   Teuchos::ParameterList *MLList;
   MLList = &paramList.sublist ( TusasmlNameString, false );
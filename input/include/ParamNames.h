@@ -94,6 +94,118 @@ std::string const TusasqtriquadordDocString = "quadrature order for biquadratic
 std::string const TusasexaConstitNameString = "exaconstit";
 /// Dump exaConstit file
 std::string const TusasexaConstitDocString = "exaconstit (bool): true; false (default)";
+/// Explicit time integration.
+std::string const TusasexplicitNameString = "explicit";
+/// Explicit time integration.
+std::string const TusasexplicitDocString = "explicit time integration with lumped mass, tpetra method only; not available for testcases that couple time derivatives across equations (farzadi) (string): none (default); euler; rk2; rk3";
+/// Operator split sub-cycling.
+std::string const TusassubcycleNameString = "subcycle";
+/// Operator split sub-cycling.
+std::string const TusassubcycleDocString = "explicit substeps per timestep for each equation, tpetra method only; not available for testcases that couple time derivatives across equations (farzadi); 0 is implicit, {} corresponds to none, {0,10} advances 2 with 10 lumped mass forward euler substeps then 1 implicitly (string): default none";
+/// Mesh decomposition method.
+std::string const TusasdecompmethodNameString = "decompmethod";
+/// Mesh decomposition method.
+std::string const TusasdecompmethodDocString = "mesh decomposition for more than 1 proc (string): nemslice (default), nem_slice and nem_spread write decomp/; linear, each proc reads a contiguous range of elements directly from the global mesh file; rcb, rib, hsfc, graph, as linear then repartitioned in parallel with zoltan";
+/// Mesh renumbering.
+std::string const TusasrenumberNameString = "renumber";
+/// Mesh renumbering.
+std::string const TusasrenumberDocString = "renumber local nodes and elements for locality (string): none (default); hilbert; morton; rcm";
+/// Color-contiguous element numbering.
+std::string const TusascolorcontiguousNameString = "colorcontiguous";
+/// Color-contiguous element numbering.
+std::string const TusascolorcontiguousDocString = "renumber elements so each color is a contiguous range, tpetra only (bool): false (default); true";
+/// Color cache directory.
+std::string const TusascolorcacheNameString = "colorcache";
+/// Color cache directory.
+std::string const TusascolorcacheDocString = "directory of element colorings cached by a hash of the local mesh and the proc count; later runs on the same mesh and decomposition read them instead of recoloring, tpetra only (string): \"\" (default) is no cache";
+/// Compact mesh storage.
+std::string const TusascompactmeshNameString = "compactmesh";
+/// Compact mesh storage.
+std::string const TusascompactmeshDocString = "drop z in 2D and store connectivity as 16 bit offsets where possible (bool): false (default); true";
+/// Geometry cache.
+std::string const TusasgeometrycacheNameString = "geometrycache";
+/// Geometry cache.
+std::string const TusasgeometrycacheDocString = "store jac*wt, Gauss point coordinates and basis gradients per element instead of recomputing them each fill, tpetra only (bool): false (default); true";
+/// Asynchronous output.
+std::string const TusasasyncoutputNameString = "asyncoutput";
+/// Asynchronous output.
+std::string const TusasasyncoutputDocString = "write exodus output on a background thread while the next timestep proceeds, tpetra only (bool): false (default); true";
+/// Global output.
+std::string const TusasglobaloutputNameString = "globaloutput";
+/// Global output.
+std::string const TusasglobaloutputDocString = "gather output to proc 0 and write a single results.e instead of per proc files joined with epu, tpetra only (bool): false (default); true";
+/// Output precision.
+std::string const TusasoutputfloatNameString = "outputfloat";
+/// Output precision.
+std::string const TusasoutputfloatDocString = "store the output file, coordinates included, in single precision, tpetra only (bool): false (default); true";
+/// Output compression.
+std::string const TusasoutputcompressionNameString = "outputcompression";
+/// Output compression.
+std::string const TusasoutputcompressionDocString = "zlib compression level 1-9 of the output file, needs exodus with netcdf4, tpetra only (int): 0 (default) is none";
+/// Output digits.
+std::string const TusasoutputdigitsNameString = "outputdigits";
+/// Output digits.
+std::string const TusasoutputdigitsDocString = "significant decimal digits kept in the output for each equation, tpetra only; lossy, the dropped bits are zeroed so they compress well; 0 keeps full precision, {0,3} keeps 3 digits of equation 2 (string): default {}";
+/// In situ analysis.
+std::string const TusasinsituNameString = "insitu";
+/// In situ analysis.
+std::string const TusasinsituDocString = "equations reduced in situ to insitu.csv next to the results files (volume, mean, norm1 = int |u|, norm2 = sqrt(int u^2), min, max, interface area, volume fraction, histogram), eg {0,1}, tpetra only (string): default {} is none";
+/// In situ analysis frequency.
+std::string const TusasinsitufreqNameString = "insitufreq";
+/// In situ analysis frequency.
+std::string const TusasinsitufreqDocString = "timesteps between in situ reductions (int): 1 (default)";
+/// In situ analysis histogram.
+std::string const TusasinsitubinsNameString = "insitubins";
+/// In situ analysis histogram.
+std::string const TusasinsitubinsDocString = "number of volume weighted histogram bins over [insitumin, insitumax] (int): 0 (default) is none";
+/// In situ analysis range.
+std::string const TusasinsituminNameString = "insitumin";
+/// In situ analysis range.
+std::string const TusasinsituminDocString = "lower end of the range of the reduced fields; the midpoint of the range separates the phases and its width scales the interface area (double): 0. (default)";
+/// In situ analysis range.
+std::string const TusasinsitumaxNameString = "insitumax";
+/// In situ analysis range.
+std::string const TusasinsitumaxDocString = "upper end of the range of the reduced fields (double): 1. (default)";
+/// Region output frequency.
+std::string const TusasregionfreqNameString = "regionfreq";
+/// Region output frequency.
+std::string const TusasregionfreqDocString = "write the elements passing the region filters to region.e every regionfreq timesteps, alongside the full output; a restart continues the series region.e, region.e-s.0002, ...; tpetra only (int): 0 (default) is off";
+/// Region output bounding box.
+std::string const TusasregionboxNameString = "regionbox";
+/// Region output bounding box.
+std::string const TusasregionboxDocString = "keep elements with a node in the box {xmin,xmax,ymin,ymax[,zmin,zmax]} (string): {} (default) is no box";
+/// Region output node set.
+std::string const TusasregionnodesetNameString = "regionnodeset";
+/// Region output node set.
+std::string const TusasregionnodesetDocString = "keep elements with a node in this node set (int): -1 (default) is no node set";
+/// Region output stride.
+std::string const TusasregionstrideNameString = "regionstride";
+/// Region output stride.
+std::string const TusasregionstrideDocString = "keep every regionstride-th element by global id (int): 1 (default) is every element";
+/// Region output threshold field.
+std::string const TusasregionfieldNameString = "regionfield";
+/// Region output threshold field.
+std::string const TusasregionfieldDocString = "keep elements where this equation takes values in regionwindow, eg a moving window around an interface (int): -1 (default) is no threshold";
+/// Region output threshold window.
+std::string const TusasregionwindowNameString = "regionwindow";
+/// Region output threshold window.
+std::string const TusasregionwindowDocString = "range {lo,hi} of regionfield, an element is kept when its nodal values overlap it (string): {0.,1.} (default)";
+/// Checkpoint frequency.
+std::string const TusascheckpointfreqNameString = "checkpointfreq";
+/// Checkpoint frequency.
+std::string const TusascheckpointfreqDocString = "write a binary restart checkpoint every checkpointfreq timesteps, independent of outputfreq; checkpoint.N.p files go next to the results files, tpetra only (int): 0 (default) is off";
+/// Checkpoint wall time.
+std::string const TusascheckpointwalltimeNameString = "checkpointwalltime";
+/// Checkpoint wall time.
+std::string const TusascheckpointwalltimeDocString = "write a binary restart checkpoint once this many seconds of wall time have passed since the last one, tpetra only (double): 0. (default) is off";
+/// Restart from checkpoint.
+std::string const TusasrestartcheckpointNameString = "restartcheckpoint";
+/// Restart from checkpoint.
+std::string const TusasrestartcheckpointDocString = "restart from the binary checkpoint files instead of the exodus output; restartnumproc gives the number of procs that wrote them, tpetra only (bool): false (default); true";
+/// Restart number of procs.
+std::string const TusasrestartnumprocNameString = "restartnumproc";
+/// Restart number of procs.
+std::string const TusasrestartnumprocDocString = "number of procs that wrote the restart files; when it differs from the current number the solution is read by global node id and redistributed, 1 reads the global (joined or globaloutput) results.e (int): 0 (default) is the current number, or 1 with globaloutput";
 
 //other parameters not in the input file
 /// Restart.
@@ -14,6 +14,33 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
+
+/// Non-owning view of a contiguous run of ints, e.g. one row of a compressed row (CSR) array.
+/** Valid until the owning Mesh array is recomputed. */
+class mesh_span
+{
+ public:
+  /// Constructor
+  mesh_span() : data_(NULL), size_(0) {}
+  /// Constructor
+  mesh_span(const int *d, const int n) : data_(d), size_(n) {}
+  /// Constructor
+  mesh_span(const std::vector<int> &v) : data_(v.data()), size_(v.size()) {}
+  /// Return the number of entries.
+  int size() const {return size_;}
+  /// Return true if there are no entries.
+  bool empty() const {return 0 == size_;}
+  /// Return entry i.
+  const int& operator[](const int i) const {return data_[i];}
+  /// Return a pointer to the first entry.
+  const int* data() const {return data_;}
+  const int* begin() const {return data_;}
+  const int* end() const {return data_ + size_;}
+ private:
+  const int *data_;
+  int size_;
+};
 
 /// Manages all mesh data.
 class Mesh
@@ -38,6 +65,10 @@ class Mesh
 // We need to read and write Exodus files
   /// Read exodus file based on filename.
   int read_exodus(const char * filename);
+  /// Read this processor's part of the global (undecomposed) exodus file filename directly with partial reads.
+  /** Elements are read in contiguous ranges by id; method = linear keeps that partition, rcb, rib, hsfc or graph
+      repartition in parallel with zoltan. Node ownership and comm maps are built in process. */
+  int read_exodus_partial(const char * filename, const std::string method = "linear");
   /// Write exodus file based on filename.
   int write_exodus(const char * filename);
   /// Write exodus file based on exodus id ex_id.
@@ -47,6 +78,21 @@ class Mesh
   int write_exodus_no_elem(const int ex_id, const int counter, const double time);
   /// Create exodus file based on filename.
   int create_exodus(const char * filename);
+  /// Create the global (undecomposed) exodus file filename on proc 0 from every proc's part of the mesh.
+  /** Collective; returns the exodus id on proc 0 and -1 on the other procs. */
+  int create_exodus_global(const char * filename);
+  /// Open the existing global exodus file filename on proc 0 to append steps with write_exodus_global.
+  /** Collective; returns the exodus id on proc 0 and -1 on the other procs. */
+  int open_exodus_global(const char * filename);
+  /// Gather the nodal and elem fields of every proc to proc 0 by global id; collective.
+  void gather_exodus_global();
+  /// Write the fields gathered by gather_exodus_global to the global file ex_id at timestep counter and time time; proc 0 only.
+  int write_exodus_global(const int ex_id, const int counter, const double time);
+  /// Create the exodus side file filename holding only the elements elems (local ids) and the nodes they use.
+  /** Not collective; every proc writes its own file. Node and elem num maps give the global ids. */
+  int create_exodus_subset(const char * filename, const std::vector<int> &elems);
+  /// Write the nodal and elem fields of the elements given to create_exodus_subset to ex_id at timestep counter and time time.
+  int write_exodus_subset(const int ex_id, const int counter, const double time);
   /// Open exodus file based on filename.
   int open_exodus(const char * filename);
   /// Read time from exodus file with id ex_id and timestep counter.
@@ -57,6 +103,10 @@ class Mesh
   int read_nodal_data_exodus(const int ex_id, const int timestep, const int index, double *data);
   /// Read nodal data by variable name name at timestep index timestep.
   int read_nodal_data_exodus(const int ex_id, const int timestep, std::string name, double *data);
+  /// Read part part of num_parts of the nodes in exodus file filename at its last timestep.
+  /** Returns the timestep, its time, the 0 based global ids of the nodes read and, for each name in names, their values. */
+  int read_nodal_data_exodus(const char * filename, const std::vector<std::string> &names, const int part, const int num_parts,
+			     int &timestep, double &time, std::vector<int> &gids, std::vector<std::vector<double> > &data);
   /// Read the number of processors from Nemesis file with exodus id ex_id.
   int read_num_proc_nemesis(int ex_id, int *nproc);
   /// Read elem data by variable index index at timestep index timestep.
@@ -66,6 +116,15 @@ class Mesh
 
 // We need a set of convenient functions to retrieve data from this object, and write data to it
 
+  /// Renumber local nodes and elements for locality with method hilbert, morton or rcm (reverse Cuthill-McKee).
+  /** Permutes coordinates, connectivity, node sets, side sets and comm maps; global ids are unchanged. Call before any compute_* method. */
+  void renumber(const std::string method);
+  /// Permute local elements, e2o[new local id] = old local id; elements must stay in their block.
+  /** Permutes connectivity, elem_num_map, element fields and side set elements; global ids are unchanged. */
+  void permute_elems(const std::vector<int> &e2o);
+  /// Compact mesh storage: drop z in 2D and store connectivity as a base node plus 16 bit offsets per element where they fit.
+  /** Connectivity is then only available through get_node_id; call after renumber, permute_elems and anything else that edits connect. */
+  void compact();
   /// Compute the nodal adjacencies. Must be called before any call to get_nodal_adj(int i).
   void compute_nodal_adj();
   /// Compute the elemental adjacencies.
@@ -73,9 +132,10 @@ class Mesh
   /// Compute nodal patch elements. Must be called before any call to get_nodal_patch(int i).
   void compute_nodal_patch_old();
   void compute_nodal_patch_overlap();
-  /// Return a std::vector<int> of elements (by local id) in nodal patch for node i (by local id).
-  std::vector<int> get_nodal_patch(int i){return nodal_patch[i];}
-  std::vector<int> get_nodal_patch_overlap(int i){return nodal_patch_overlap[i];}
+  /// Return a view of the elements (by local id) in nodal patch for node i (by local id).
+  mesh_span get_nodal_patch(int i){return csr_row(nodal_patch_idx, nodal_patch_array, i);}
+  /// Return a view of the elements (by local id) in overlap nodal patch for node i (by local id).
+  mesh_span get_nodal_patch_overlap(int i){return csr_row(nodal_patch_overlap_idx, nodal_patch_overlap_array, i);}
 
   /// Add nodal data as std::vector<double> with name name
   int add_nodal_data(std::string name, std::vector<double> &data);
@@ -85,10 +145,16 @@ class Mesh
   int add_nodal_field(const std::string name);
   /// Update nodal data as an array with name name
   int update_nodal_data(const std::string name, const double *data);
+  /// Update nodal data with name name from a strided array, node j is data[stride*j]
+  int update_nodal_data(const std::string name, const double *data, const int stride);
   /// Add an element field with name name
   int add_elem_field(const std::string name);
   /// Update element data as an array with name name
   int update_elem_data(const std::string name, const double *data);
+  /// Keep digits significant decimal digits of nodal field name from now on; 0 keeps full precision
+  int set_nodal_field_digits(const std::string name, const int digits);
+  /// Store output files in single precision if single; zlib compress them at level compression (1-9) if exodus has netcdf4, 0 is off
+  void set_output_options(const bool single, const int compression);
   /// Toggle verbosity
   void set_verbose(const bool v = true);
 
@@ -114,8 +180,10 @@ class Mesh
   int get_num_elem_in_blk(int blk){ return num_elem_in_blk[blk];}
   /// Return the number of nodes in an element in block blk
   int get_num_nodes_per_elem_in_blk(int blk){ return num_node_per_elem_in_blk[blk];}
-  /// Return address of node id (by local id) in element elem (by local id) in block blk with offest offset.
-  int& get_node_id(int blk, int elem, int offset){return connect[blk][elem * num_node_per_elem_in_blk[blk] + offset]; }
+  /// Return node id (by local id) in element elem (by local id) in block blk with offest offset.
+  int get_node_id(int blk, int elem, int offset){
+    const int i = elem * num_node_per_elem_in_blk[blk] + offset;
+    return connect[blk].empty() ? connect_base[blk][elem] + connect_offset[blk][i] : connect[blk][i]; }
   /// Return global node id of local index i
   int get_global_node_id(int i){ return node_num_map[i];}
   /// Return global element id of local index i
@@ -126,26 +194,40 @@ class Mesh
   std::vector<int> *get_elem_num_map(){ return &elem_num_map; }
   /// Return my_node_num_map, a list of global node ids on this processor.
   std::vector<int> get_my_node_num_map(){ return my_node_num_map; }
-  /// Return element_connect for element i, by local id
-  std::vector<int> get_elem_connect(int i){return elem_connect[i];};
+  /// Return a view of elem_connect for element i, by local id
+  mesh_span get_elem_connect(int i){return csr_row(elem_connect_idx, elem_connect_array, i);};
   /// Return the x coord of node i
   double get_x(int i){return x[i];}    
   /// Return the y coord of node i
   double get_y(int i){return y[i];} 
-  /// Return the z coord of node i
-  double get_z(int i){return z[i];}
-  /// Return the nodal adjacency for node i, local id, serial
-  std::vector<int> get_nodal_adj(int i){return nodal_adj[i];}
-  /// Return node set with id i
-  std::vector<int> get_node_set(int i){return ns_node_list[i];}
-  /// Return side set with id i
-  std::vector<int> get_side_set(int i){return ss_side_list[i];}  
-  /// Return the nodes in side set with id i, by local id
-  std::vector<int> get_side_set_node_list(int i){return ss_node_list[i];}
+  /// Return the z coord of node i, 0 for a compacted 2D mesh
+  double get_z(int i){return z.empty() ? 0. : z[i];}
+  /// Return a view of the nodal adjacency for node i, local id, serial
+  mesh_span get_nodal_adj(int i){return csr_row(nodal_adj_idx, nodal_adj_array, i);}
+  /// Read the node and side sets now, if they are still on disk
+  void load_sets(){
+    if(!is_node_sets_loaded) load_node_sets();
+    if(!is_side_sets_loaded) load_side_sets();}
+  /// Return a view of node set with id i
+  mesh_span get_node_set(int i){
+    if(!is_node_sets_loaded) load_node_sets();
+    return csr_row(ns_node_idx, ns_node_array, i);}
+  /// Return a view of side set with id i
+  mesh_span get_side_set(int i){
+    if(!is_side_sets_loaded) load_side_sets();
+    return csr_row(ss_elem_idx, ss_side_array, i);}
+  /// Return a view of the nodes in side set with id i, by local id
+  mesh_span get_side_set_node_list(int i){
+    if(!is_side_sets_loaded) load_side_sets();
+    return csr_row(ss_node_idx, ss_node_array, i);}
   /// Return node id of node j in node set with id i, by local id
-  int get_node_set_entry(int i, int j){return ns_node_list[i][j];}
+  int get_node_set_entry(int i, int j){
+    if(!is_node_sets_loaded) load_node_sets();
+    return ns_node_array[ns_node_idx[i] + j];}
   /// Return node id of node j in side set with id i, by local id
-  int get_side_set_node_entry(int i, int j){return ss_node_list[i][j];}
+  int get_side_set_node_entry(int i, int j){
+    if(!is_side_sets_loaded) load_side_sets();
+    return ss_node_array[ss_node_idx[i] + j];}
   /// Return the exodus name of the elements in blok i
   std::string get_blk_elem_type(const int i){return blk_elem_type[i];}
   /// Set global_file_name to filename
@@ -154,10 +236,10 @@ class Mesh
   int get_local_id(int gid);
   /// Creates sorted nodesetlists based on increasing x, y and z. Used for periodic BCs.
   void create_sorted_nodesetlists();
-  /// Return sorted node set with id i
-  std::vector<int> get_sorted_node_set(int i){return sorted_ns_node_list[i];}
+  /// Return a view of sorted node set with id i
+  mesh_span get_sorted_node_set(int i){return csr_row(ns_node_idx, sorted_ns_node_array, i);}
   /// Return node id of sorted node j in node set with id i, by local id
-  int get_sorted_node_set_entry(int i, int j){return sorted_ns_node_list[i][j];}
+  int get_sorted_node_set_entry(int i, int j){return sorted_ns_node_array[ns_node_idx[i] + j];}
   /// Creates sorted nodelist based on increasing x, y and z. Used for projection method.
   void create_sorted_nodelist();
   /// Return sorted node list
@@ -174,18 +256,21 @@ class Mesh
  private:
 
   /// Return the number of nodes in side set with id i   !!! is this global or local !!!
-  int get_num_node_per_side(int i){return ss_ctr_list[i][0];}
-  /// Return my node_num_mapi (on this processor)   !!! is this global or local !!!
+  int get_num_node_per_side(int i){
+    if(!is_side_sets_loaded) load_side_sets();
+    return ss_num_node_per_side[i];}
+  /// Return my node_num_mapi, local ids of the internal nodes on this processor
   std::vector<int> get_my_node_num_mapi(){ return node_mapi; }
-  /// Return my node_num_mapb (on this processor)   !!! is this global or local !!!
+  /// Return my node_num_mapb, local ids of the border nodes on this processor
   std::vector<int> get_my_node_num_mapb(){ return node_mapb; }
-  /// Return a pointer to the node ids in element elem in block blk   !!! is this global or local !!!
-  int *get_elem_nodes(int blk, int elem){return &connect[blk][elem * num_node_per_elem_in_blk[blk]]; }
+  /// Copy the local node ids of element elem in block blk to nodes
+  void get_elem_nodes(int blk, int elem, int *nodes){
+    for(int k = 0; k < num_node_per_elem_in_blk[blk]; k++) nodes[k] = get_node_id(blk, elem, k); }
   /// Return the number of node sets   !!! is this global or local !!!
   int get_num_node_sets(){return num_node_sets;}
   /// Return the number of side sets   !!! is this global or local !!!
   int get_num_side_sets(){return num_side_sets;}
-  /// Compute nodal patch elements.
+  /// Compute nodal patch elements (by global id) for nodes on this processor, from the local partition and a halo exchange over the node comm maps.
   void compute_nodal_patch();
   /// Return the x vector   !!! is this global or local !!!
   std::vector<double> *get_x_vector(){ return &x;}
@@ -206,9 +291,13 @@ class Mesh
   /// Return boundary status of node nodeid   !!! is this global or local !!!
   int get_node_boundary_status(int nodeid);
   /// !!! have no idea !!!
-  int get_node_set_value(int i){ return node_set_map[i]; }
+  int get_node_set_value(int i){
+    if(!is_node_sets_loaded) load_node_sets();
+    return node_set_map[i]; }
   /// !!! have no idea !!!
-  int get_side_set_node_value(int i){ return side_set_node_map[i]; }
+  int get_side_set_node_value(int i){
+    if(!is_side_sets_loaded) load_side_sets();
+    return side_set_node_map[i]; }
   std::vector<int> node_num_map;
 
   bool verbose;
@@ -235,26 +324,48 @@ class Mesh
   std::vector<std::string> blk_elem_type;
   std::vector<int> num_node_per_elem_in_blk;
   //std::vector<std::vector<int> > connect;
-  std::vector< std::vector <int> > elem_connect;      
+  /// Compacted connectivity, per block: node k of elem e is connect_base[blk][e] + connect_offset[blk][e*n+k]; used when connect[blk] is empty
+  std::vector<std::vector<int> > connect_base;
+  std::vector<std::vector<unsigned short> > connect_offset;
+  /// elem_connect in CSR form: row ne is elem_connect_array[elem_connect_idx[ne]:elem_connect_idx[ne+1]]
+  std::vector<int> elem_connect_idx;
+  std::vector<int> elem_connect_array;
 
   std::vector<int> ss_ids;
   std::vector<int> num_sides_per_ss;
   std::vector<int> num_df_per_ss;
-  std::vector<std::vector<int> > ss_elem_list;
-  std::vector<std::vector<int> > ss_side_list;
-  std::vector<std::vector<int> > ss_node_list;
-  std::vector<std::vector<int> > ss_ctr_list;
+  /// Side sets in CSR form: elems (1 based) and sides of set i share ss_elem_idx, nodes (local id) use ss_node_idx
+  std::vector<int> ss_elem_idx;
+  std::vector<int> ss_elem_array;
+  std::vector<int> ss_side_array;
+  std::vector<int> ss_node_idx;
+  std::vector<int> ss_node_array;
+  std::vector<int> ss_num_node_per_side;
 
   std::vector<int> ns_ids;
   std::vector<int> num_nodes_per_ns;
   std::vector<int> num_df_per_ns;
-  std::vector<std::vector<int> > ns_node_list;
-  std::vector<std::vector<int> > sorted_ns_node_list;
+  /// Node sets in CSR form, by local id; the sorted copy shares ns_node_idx
+  std::vector<int> ns_node_idx;
+  std::vector<int> ns_node_array;
+  std::vector<int> sorted_ns_node_array;
+
+  /// Sets are read from set_file_name on first use; read_exodus only reads their sizes
+  bool is_node_sets_loaded;
+  bool is_side_sets_loaded;
+  std::string set_file_name;
+  /// Renumbering applied to sets that were not loaded yet, old to new local id; empty is the identity
+  std::vector<int> set_node_o2n;
+  std::vector<int> set_elem_o2e;
+  /// Read the node sets from set_file_name
+  void load_node_sets();
+  /// Read the side sets from set_file_name
+  void load_side_sets();
   //std::vector<std::vector<int> > ns_ctr_list;
 
-  std::vector<std::vector<int> > nodal_adj; //cn we may only need this for epetra
-  //std::vector<int> nodal_adj_idx;
-  //std::vector<int> nodal_adj_array;
+  /// nodal_adj in CSR form //cn we may only need this for epetra
+  std::vector<int> nodal_adj_idx;
+  std::vector<int> nodal_adj_array;
 
   std::vector<std::string> nodal_field_names;      
   std::vector<std::vector<double> > nodal_fields;
@@ -270,6 +381,38 @@ class Mesh
   int write_nodal_data_exodus(int ex_id, int counter);
   int write_elem_data_exodus(int ex_id, int counter);
   int write_elem_data_exodus(int ex_id);
+  /// Write coordinates, sets and element blocks to ex_id, unless already written there
+  int write_geometry_exodus(int ex_id);
+  /// Write the nodal variable count and names to ex_id, unless already written there
+  int write_nodal_var_names_exodus(int ex_id);
+  /// Write the elem variable count and names to ex_id, unless already written there
+  int write_elem_var_names_exodus(int ex_id);
+  /// Drop what has been recorded as written to ex_id
+  void forget_exodus(int ex_id);
+  /// Local ids of the nodes this proc sends to the global file: all but its external nodes
+  std::vector<int> global_out_node_lid;
+  /// Proc 0 only: global node and elem ids in gather order, and the gathered fields by global id
+  std::vector<int> global_out_node_gid;
+  std::vector<int> global_out_elem_gid;
+  std::vector<std::vector<double> > global_nodal_fields;
+  std::vector<std::vector<double> > global_elem_fields;
+  /// Local ids of the nodes and elems in the last create_exodus_subset file, and its elem count per block
+  std::vector<int> subset_node_lid;
+  std::vector<int> subset_elem_lid;
+  std::vector<int> subset_elem_blk_cnts;
+  /// exodus ids the geometry and the variable names have been written to; -1 if none
+  int geometry_ex_id;
+  int nodal_var_ex_id;
+  int elem_var_ex_id;
+  /// Word size and compression level of output files, see set_output_options
+  int output_io_ws;
+  int output_compression;
+  /// Mantissa bits kept per nodal field, by field index; missing or 52 is full precision
+  std::vector<int> nodal_field_bits;
+  /// Create filename with the output word size and mode
+  int create_exodus_file(const char * filename);
+  /// Apply the output options that are set per exodus id
+  void set_exodus_options(const int ex_id);
   int close_exodus(int ex_id);
   void check_exodus_error(const int ex_err,const std::string msg);
   int get_nodal_field_index(std::string name);
@@ -291,7 +434,7 @@ class Mesh
 
   std::vector<int> node_cmap_ids, node_cmap_node_cnts, elem_cmap_ids, elem_cmap_elem_cnts;
 
-  std::vector<int> elem_mapi, elem_mapb, node_mapi, node_mapb, node_mape;
+  std::vector<int> elem_mapi, elem_mapb, node_mapi, node_mapb, node_mape;//cn local ids
 
   std::vector<int> global_ns_ids, num_global_node_counts, num_global_node_df_counts;
   std::vector<int> global_ss_ids, num_global_side_counts, num_global_side_df_counts;
@@ -300,8 +443,17 @@ class Mesh
   std::vector<std::vector<int> > node_ids_in_cmap, n_proc_ids_in_cmap;
   std::vector<std::vector<int> > elem_ids_in_cmap, e_side_ids_in_cmap, e_proc_ids_in_cmap;
 
-  std::vector<std::vector<int> > nodal_patch;//[nodeid][elemnt ids in patch
-  std::vector<std::vector<int> > nodal_patch_overlap;//[nodeid][elemnt ids in patch
+  /// nodal patches in CSR form: [nodeid][elemnt ids in patch
+  std::vector<int> nodal_patch_idx, nodal_patch_array;
+  std::vector<int> nodal_patch_overlap_idx, nodal_patch_overlap_array;
+
+  /// Return a view of row i of the CSR pair idx, array.
+  mesh_span csr_row(const std::vector<int> &idx, const std::vector<int> &array, const int i) const
+  {return mesh_span(array.data() + idx[i], idx[i+1] - idx[i]);}
+  /// Turn per row counts in idx (size nrows + 1, counts in idx[1:]) into offsets and size array.
+  void csr_offsets(std::vector<int> &idx, std::vector<int> &array);
+  /// Sort each row of the CSR pair idx, array, remove duplicates and compact.
+  void csr_sort_unique(std::vector<int> &idx, std::vector<int> &array);
 
   int proc_id, nprocs, nprocs_infile;
 
@@ -313,6 +465,24 @@ class Mesh
 
   bool is_global_node_local(int i);
   bool is_global_elem_local(int i);
+
+  /// Return owner, sharing procs and coords (3 per node) of the sorted global nodes gids via a distributed node directory.
+  void partial_node_directory(const int ex_id, const std::vector<int> &gids, std::vector<int> &owner,
+			      std::vector<std::vector<int> > &sharers, std::vector<double> &xyz);
+  /// Repartition global elements egid in blocks eblk with connectivity econn with zoltan method method, and migrate them.
+  void partition_zoltan(const int ex_id, const std::string method, std::vector<int> &egid,
+			std::vector<int> &eblk, std::vector<int> &econn);
+  /// Build the local mesh from global elements egid in blocks eblk with connectivity econn (global node ids).
+  void build_partial_mesh(const int ex_id, const std::vector<int> &egid, const std::vector<int> &eblk,
+			  const std::vector<int> &econn);
+  /// Build the global to local hashes below; called at the end of read_exodus.
+  void compute_global_to_local();
+  /// Global node id to index in node_num_map.
+  std::unordered_map<int,int> node_gid_to_lid;
+  /// Global node id to index in my_node_num_map.
+  std::unordered_map<int,int> my_node_gid_to_lid;
+  /// Global elem id to index in elem_num_map.
+  std::unordered_map<int,int> elem_gid_to_lid;
   bool is_nodesets_sorted;
   bool is_compute_nodal_patch_overlap;
   std::vector<int> sorted_node_num_map;
@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) Triad National Security, LLC.  This file is part of the
+//  Tusas code (LA-CC-17-001) and is subject to the revised BSD license terms
+//  in the LICENSE file found in the top-level directory of this distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#ifndef INSITU_ANALYSIS_H
+#define INSITU_ANALYSIS_H
+
+#include "Mesh.h"
+
+#include <Teuchos_RCP.hpp>
+
+#include <Epetra_Comm.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+/// In situ reductions of solution fields.
+/** Each call to process() makes one pass over the elements of the mesh and computes, for every
+    selected field, the volume, mean, L1 and L2 norms, min, max, an interface area estimate,
+    the volume fraction above the phase separating level and a volume weighted histogram.
+    The volume, the norms, the interface area and the histogram are integrals over the mesh,
+    norm1 = int |u| and norm2 = sqrt(int u^2); the mean and the fraction are divided by the volume.
+    Proc 0 buffers one csv line per field and appends the buffer to the csv file on a
+    background thread, so the reductions can run far more often than full field output. */
+class insitu_analysis
+{
+public:
+  /// Constructor
+  /** The fields are the equation indices \p fields of a solution with \p numeqs equations.
+      \p umin and \p umax give the range of the fields: the histogram spans it with \p bins bins,
+      its midpoint separates the phases and its width scales the interface area. */
+  insitu_analysis(const Teuchos::RCP<const Epetra_Comm>& comm,  ///< MPI communicator
+		  Mesh *mesh, ///< mesh object
+		  const std::vector<std::string> &names, ///< names of all the equations
+		  const std::vector<int> &fields, ///< equations to reduce
+		  const int bins, ///< number of histogram bins, 0 for none
+		  const double umin, ///< lower end of the field range
+		  const double umax, ///< upper end of the field range
+		  const std::string filename, ///< csv file
+		  const bool append ///< append to an existing file, eg on restart
+		  );
+  /// Destructor
+  /** Writes out anything still buffered. */
+  ~insitu_analysis();
+  /// Reduce the fields at timestep \p step and time \p time.
+  /** \p u holds the values of equation k at overlap node j in <CODE>u[numeqs*j+k]</CODE>. Collective. */
+  void process(const int step, ///< timestep index
+	       const double time, ///< current time
+	       const double *u ///< interleaved overlap solution array
+	       );
+  /// Hand the buffered lines to the writer thread.
+  /** With \p wait the lines are on disk when it returns. */
+  void flush(const bool wait = false);
+
+private:
+  /// Mesh object.
+  Mesh *mesh_;
+  /// MPI comm object.
+  const Teuchos::RCP<const Epetra_Comm>  comm_;
+  /// Names of the equations.
+  std::vector<std::string> names_;
+  /// Equations to reduce.
+  std::vector<int> fields_;
+  /// Total number of equations.
+  int numeqs_;
+  /// Number of histogram bins.
+  int bins_;
+  /// Field range.
+  double umin_, umax_;
+  /// Output filename
+  std::string filename_;
+  /// Lines not yet handed to the writer.
+  std::string buffer_;
+  /// Lines being written by writer_.
+  std::string pending_;
+  /// Background writer.
+  std::thread writer_;
+};
+#endif
@@ -86,6 +86,8 @@ private:
   Teuchos::RCP<const Epetra_Import> importer_;
   /// Vector of the nodal values.
   Teuchos::RCP<Epetra_Vector> ppvar_;
+  /// Overlap copy of ppvar_ used for output.
+  Teuchos::RCP<Epetra_Vector> ppvar_overlap_;
   /// Scalar operator
   SCALAR_OP s_op_;
   /// Output precision 
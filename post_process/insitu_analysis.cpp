@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) Triad National Security, LLC.  This file is part of the
+//  Tusas code (LA-CC-17-001) and is subject to the revised BSD license terms
+//  in the LICENSE file found in the top-level directory of this distribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include "insitu_analysis.h"
+#include "basis.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//cn sums per field: volume, int u, int |u|, int u^2, int |grad u|, volume above the level, then the bins
+#define INSITU_NUM_SUMS 6
+
+insitu_analysis::insitu_analysis(const Teuchos::RCP<const Epetra_Comm>& comm,
+				 Mesh *mesh,
+				 const std::vector<std::string> &names,
+				 const std::vector<int> &fields,
+				 const int bins,
+				 const double umin,
+				 const double umax,
+				 const std::string filename,
+				 const bool append):
+  mesh_(mesh),
+  comm_(comm),
+  names_(names),
+  fields_(fields),
+  numeqs_(names.size()),
+  bins_(bins),
+  umin_(umin),
+  umax_(umax),
+  filename_(filename)
+{
+  if( umax_ <= umin_ ){
+    if( 0 == comm_->MyPID() ) std::cout<<"In situ analysis needs a field range with min < max."<<std::endl;
+    exit(0);
+  }
+  for(int k = 0; k < fields_.size(); k++){
+    if( 0 > fields_[k] || numeqs_ <= fields_[k] ){
+      if( 0 == comm_->MyPID() ) std::cout<<"In situ analysis equation "<<fields_[k]<<" does not exist."<<std::endl;
+      exit(0);
+    }
+  }
+
+  if ( 0 == comm_->MyPID() && !append ){
+    std::ofstream outfile;
+    outfile.open(filename_);
+    outfile<<"time,step,field,volume,mean,norm1,norm2,min,max,interface,fraction";
+    for(int b = 0; b < bins_; b++) outfile<<",h"<<b;
+    outfile<<std::endl;
+    outfile.close();
+  }
+
+  if ( 0 == comm_->MyPID())
+    std::cout<<"In situ analysis created for "<<fields_.size()<<" fields"<<std::endl<<std::endl;
+};
+
+insitu_analysis::~insitu_analysis(){
+
+  flush(true);
+};
+
+void insitu_analysis::process(const int step, const double time, const double *u)
+{
+  const int nf = fields_.size();
+  const int nsum = INSITU_NUM_SUMS + bins_;
+  const int dim = mesh_->get_num_dim();
+  const double level = .5*(umin_ + umax_);
+  const double width = (0 < bins_) ? (umax_ - umin_)/bins_ : 0.;
+
+  std::vector<double> sums(nf*nsum, 0.);
+  //cn min is reduced as -min, so one max reduction does both
+  std::vector<double> extrema(2*nf, -std::numeric_limits<double>::max());
+
+  for(int j = 0; j < mesh_->get_num_nodes(); j++){
+    for(int f = 0; f < nf; f++){
+      const double v = u[numeqs_*j + fields_[f]];
+      extrema[2*f] = std::max(extrema[2*f], -v);
+      extrema[2*f + 1] = std::max(extrema[2*f + 1], v);
+    }
+  }
+
+  //cn every elem lives on one proc, so the integrals sum without double counting
+
+  for(int blk = 0; blk < mesh_->get_num_elem_blks(); blk++){
+
+    std::string elem_type=mesh_->get_blk_elem_type(blk);
+
+    Basis *basis;
+
+    if( (0==elem_type.compare("QUAD4")) || (0==elem_type.compare("QUAD")) || (0==elem_type.compare("quad4")) || (0==elem_type.compare("quad")) ){ // linear quad
+      basis = new BasisLQuad();
+    }
+    else if( (0==elem_type.compare("TRI3")) || (0==elem_type.compare("TRI")) || (0==elem_type.compare("tri3"))  || (0==elem_type.compare("tri"))) { // linear triangle
+      basis = new BasisLTri();
+    }
+    else if( (0==elem_type.compare("QUAD9")) || (0==elem_type.compare("quad9")) ){ // quadratic quad
+      basis = new BasisQQuad();
+    }
+    else if( (0==elem_type.compare("TRI6")) || (0==elem_type.compare("tri6"))) { // quadratic triangle
+      basis=new BasisQTri();
+    }
+    else if((0==elem_type.compare("HEX8")) || (0==elem_type.compare("HEX"))
+	    || (0==elem_type.compare("hex8")) || (0==elem_type.compare("hex"))){// hex8
+      basis=new BasisLHex();
+    }
+    else if((0==elem_type.compare("TETRA4")) || (0==elem_type.compare("TETRA"))
+	    || (0==elem_type.compare("tetra4")) || (0==elem_type.compare("tetra"))){//tet4
+      basis=new BasisLTet();
+    }
+    else{
+      std::cout<<"In situ analysis does not support "<<elem_type<<" elements."<<std::endl;
+      exit(0);
+    }
+
+    const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
+
+    std::vector<double> xx(n_nodes_per_elem), yy(n_nodes_per_elem), zz(n_nodes_per_elem);
+    std::vector<double> uu(nf*n_nodes_per_elem);
+
+    for (int ne=0; ne < mesh_->get_num_elem_in_blk(blk); ne++) {
+
+      for(int k = 0; k < n_nodes_per_elem; k++){
+	const int nodeid = mesh_->get_node_id(blk, ne, k);
+	xx[k] = mesh_->get_x(nodeid);
+	yy[k] = mesh_->get_y(nodeid);
+	zz[k] = mesh_->get_z(nodeid);
+	for(int f = 0; f < nf; f++) uu[f*n_nodes_per_elem + k] = u[numeqs_*nodeid + fields_[f]];
+      }
+
+      for(int gp=0; gp < basis->ngp; gp++) {
+	for(int f = 0; f < nf; f++){
+	  basis->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[f*n_nodes_per_elem]);
+	  const double dv = basis->jac * basis->wt;
+	  const double v = basis->uu;
+	  double grad2 = basis->dudx*basis->dudx + basis->dudy*basis->dudy;
+	  if( 3 == dim ) grad2 += basis->dudz*basis->dudz;
+
+	  double *s = &sums[f*nsum];
+	  s[0] += dv;
+	  s[1] += dv*v;
+	  s[2] += dv*std::fabs(v);
+	  s[3] += dv*v*v;
+	  s[4] += dv*std::sqrt(grad2);
+	  if( v > level ) s[5] += dv;
+	  if( 0 < bins_ ){
+	    const int b = std::min(std::max((int)std::floor((v - umin_)/width), 0), bins_ - 1);
+	    s[INSITU_NUM_SUMS + b] += dv;
+	  }
+	}//f
+      }//gp
+    }//ne
+
+    delete basis;
+  }//blk
+
+  std::vector<double> gsums(sums.size()), gextrema(extrema.size());
+  comm_->SumAll(&sums[0], &gsums[0], sums.size());
+  comm_->MaxAll(&extrema[0], &gextrema[0], extrema.size());
+
+  if( 0 != comm_->MyPID() ) return;
+
+  //cn by the coarea formula int |grad u| is the level set area integrated over the range of u,
+  //cn so for a diffuse interface between umin and umax it is about (umax - umin) times the area
+
+  std::ostringstream line;
+  line<<std::setprecision(std::numeric_limits<double>::digits10 + 1);
+  for(int f = 0; f < nf; f++){
+    const double *s = &gsums[f*nsum];
+    line<<time<<","<<step<<","<<names_[fields_[f]]
+	<<","<<s[0]
+	<<","<<s[1]/s[0]
+	<<","<<s[2]
+	<<","<<std::sqrt(s[3])
+	<<","<<-gextrema[2*f]
+	<<","<<gextrema[2*f + 1]
+	<<","<<s[4]/(umax_ - umin_)
+	<<","<<s[5]/s[0];
+    for(int b = 0; b < bins_; b++) line<<","<<s[INSITU_NUM_SUMS + b];
+    line<<"\n";
+  }
+  buffer_ += line.str();
+
+  if( (1<<16) < buffer_.size() ) flush();
+};
+
+void insitu_analysis::flush(const bool wait)
+{
+  if( buffer_.empty() ){
+    if( wait && writer_.joinable() ) writer_.join();
+    return;
+  }
+
+  //cn the previous write has to finish before its buffer is reused
+  if( writer_.joinable() ) writer_.join();
+
+  pending_.swap(buffer_);
+  buffer_.clear();
+
+  writer_ = std::thread([this](){
+      std::ofstream outfile;
+      outfile.open(filename_, std::ios::app );
+      outfile<<pending_;
+      outfile.close();
+    });
+  if( wait ) writer_.join();
+};
@@ -70,16 +70,11 @@ void post_process::process(const int i,const double *u, const double *gradu, con
 
 void post_process::update_mesh_data(){
 
-  Epetra_Vector *temp = new Epetra_Vector(*overlap_map_);
-  temp->Import(*ppvar_, *importer_, Insert);
-  int num_nodes = overlap_map_->NumMyElements();
-  std::vector<double> ppvar(num_nodes,0.);
-#pragma omp parallel for
-  for (int nn=0; nn < num_nodes; nn++) {
-      ppvar[nn]=(*temp)[nn];
-  }
+  if( Teuchos::is_null(ppvar_overlap_) )
+    ppvar_overlap_ = Teuchos::rcp(new Epetra_Vector(*overlap_map_));
+  ppvar_overlap_->Import(*ppvar_, *importer_, Insert);
   std::string ystring="pp"+std::to_string(index_);
-  mesh_->update_nodal_data(ystring, &ppvar[0]);
+  mesh_->update_nodal_data(ystring, ppvar_overlap_->Values());
 
 };
 void post_process::update_scalar_data(double time){
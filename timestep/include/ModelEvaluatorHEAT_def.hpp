@@ -136,7 +136,8 @@ ModelEvaluatorHEAT<Scalar>::createGraph()
 
   //nodes are numbered consecutively by nodeid
   for (int i=0; i < mesh_->get_num_nodes(); i++) {
-    std::vector<int> column (mesh_->get_nodal_adj(i));
+    const mesh_span adj = mesh_->get_nodal_adj(i);
+    std::vector<int> column (adj.begin(), adj.end());
 
     column.push_back(i);//cn put the diagonal in
     //cn need something here for more than one pde (see 2dstokes ex)
@@ -451,7 +452,8 @@ void ModelEvaluatorHEAT<Scalar>::evalModelImpl(
 	  
 	  int row = mesh_->get_node_set_entry(1, j);
 	  //clear row and put 1 on diagonal
-	  std::vector<int> column (mesh_->get_nodal_adj(row));
+	  const mesh_span adj = mesh_->get_nodal_adj(row);
+	  std::vector<int> column (adj.begin(), adj.end());
 	  std::vector<double> vals (column.size(),0.);
 	  column.push_back(row);
 	  vals.push_back(1.);
@@ -462,7 +464,8 @@ void ModelEvaluatorHEAT<Scalar>::evalModelImpl(
 	  
 	  int row = mesh_->get_node_set_entry(2, j);
 	  
-	  std::vector<int> column (mesh_->get_nodal_adj(row));
+	  const mesh_span adj = mesh_->get_nodal_adj(row);
+	  std::vector<int> column (adj.begin(), adj.end());
 	  std::vector<double> vals (column.size(),0.);
 	  column.push_back(row);
 	  vals.push_back(1.);
@@ -473,7 +476,8 @@ void ModelEvaluatorHEAT<Scalar>::evalModelImpl(
 	  
 	  int row = mesh_->get_node_set_entry(3, j);
 	  
-	  std::vector<int> column (mesh_->get_nodal_adj(row));
+	  const mesh_span adj = mesh_->get_nodal_adj(row);
+	  std::vector<int> column (adj.begin(), adj.end());
 	  std::vector<double> vals (column.size(),0.);
 	  column.push_back(row);
 	  vals.push_back(1.);
@@ -484,7 +488,8 @@ void ModelEvaluatorHEAT<Scalar>::evalModelImpl(
 	  
 	  int row = mesh_->get_node_set_entry(0, j);
 	  
-	  std::vector<int> column (mesh_->get_nodal_adj(row));
+	  const mesh_span adj = mesh_->get_nodal_adj(row);
+	  std::vector<int> column (adj.begin(), adj.end());
 	  std::vector<double> vals (column.size(),0.);
 	  column.push_back(row);
 	  vals.push_back(1.);
@@ -82,6 +82,10 @@ public:
   void write_matlab();
   /// Fill u and u_old with restart values.
   void restart(Teuchos::RCP<Epetra_Vector> u,Teuchos::RCP<Epetra_Vector> u_old);
+  /// Fill u and u_old from the results of a run on restart_procs procs (1 is the global results.e), redistributed by global node id.
+  void restart_redistribute(Teuchos::RCP<Epetra_Vector> u,Teuchos::RCP<Epetra_Vector> u_old, const int restart_procs);
+  /// Create the results file(s) for this decomposition.
+  void create_output();
 
 private:
 
@@ -1332,31 +1332,8 @@ template<class Scalar>
     init(u_old_);
     *u_old_old_ = *u_old_;
 
-    int mypid = comm_->MyPID();
-    int numproc = comm_->NumProc();
-    
-    if( 1 == numproc ){//cn for now
-      //if( 0 == mypid ){
-      const char *outfilename = "results.e";
-      ex_id_ = mesh_->create_exodus(outfilename);
-      
-    }
-    else{
-      std::string decompPath="decomp/";
-      //std::string pfile = decompPath+std::to_string(mypid+1)+"/results.e."+std::to_string(numproc)+"."+std::to_string(mypid);
-      
-      std::string mypidstring;
-      if ( numproc > 9 && mypid < 10 ){
-	mypidstring = std::to_string(0)+std::to_string(mypid);
-      }
-      else{
-	mypidstring = std::to_string(mypid);
-      }
-      
-      std::string pfile = decompPath+"/results.e."+std::to_string(numproc)+"."+mypidstring;
-      ex_id_ = mesh_->create_exodus(pfile.c_str());
-    }
-    
+    create_output();
+
     for( int k = 0; k < numeqs_; k++ ){
       mesh_->add_nodal_field((*varnames_)[k]);
     }
@@ -1377,12 +1354,43 @@ template<class Scalar>
     for( int k = 0; k < numeqs_; k++ ){
       mesh_->add_nodal_field((*varnames_)[k]);
     }
+    //cn a redistributed restart starts new results files with the restart state
+    if( 1 == output_step_ ) write_exodus();
   }
 //   mesh_->add_nodal_field("u");
 //   mesh_->add_nodal_field("phi");
   if( 0 == comm_->MyPID()) std::cout<<std::endl<<"initialize finished"<<std::endl<<std::endl;
 }
 
+template<class Scalar>
+void ModelEvaluatorNEMESIS<Scalar>::create_output()
+{
+  int mypid = comm_->MyPID();
+  int numproc = comm_->NumProc();
+  
+  if( 1 == numproc ){//cn for now
+    //if( 0 == mypid ){
+    const char *outfilename = "results.e";
+    ex_id_ = mesh_->create_exodus(outfilename);
+    
+  }
+  else{
+    std::string decompPath="decomp/";
+    //std::string pfile = decompPath+std::to_string(mypid+1)+"/results.e."+std::to_string(numproc)+"."+std::to_string(mypid);
+    
+    std::string mypidstring;
+    if ( numproc > 9 && mypid < 10 ){
+      mypidstring = std::to_string(0)+std::to_string(mypid);
+    }
+    else{
+      mypidstring = std::to_string(mypid);
+    }
+    
+    std::string pfile = decompPath+"/results.e."+std::to_string(numproc)+"."+mypidstring;
+    ex_id_ = mesh_->create_exodus(pfile.c_str());
+  }
+}
+
 template<class Scalar>
 void ModelEvaluatorNEMESIS<Scalar>::finalize()
 {
@@ -1892,22 +1900,9 @@ int ModelEvaluatorNEMESIS<Scalar>:: update_mesh_data()
 
   }
 
-  //int num_nodes = mesh_->get_node_num_map().size();
-
-  std::vector<std::vector<double>> output(numeqs_, std::vector<double>(num_nodes_));
-
-  for( int k = 0; k < numeqs_; k++ ){
-#pragma omp parallel for
-    for (int nn=0; nn < num_nodes_; nn++) {
-      output[k][nn]=(*temp)[numeqs_*nn+k];
-    }
-//     outputu[nn]=(*u_old_)[numeqs_*nn];
-//     outputphi[nn]=(*u_old_)[numeqs_*nn+1];
-    //std::cout<<comm_->MyPID()<<" "<<nn<<" "<<outputu[nn]<<" "<<outputphi[nn]<<std::endl;
-  }
   int err = 0;
   for( int k = 0; k < numeqs_; k++ ){
-    mesh_->update_nodal_data((*varnames_)[k], &output[k][0]);
+    mesh_->update_nodal_data((*varnames_)[k], temp->Values() + k, numeqs_);
   }
 
   boost::ptr_vector<error_estimator>::iterator it;
@@ -1991,6 +1986,15 @@ void ModelEvaluatorNEMESIS<Scalar>::restart(Teuchos::RCP<Epetra_Vector> u,Teucho
   int numproc = comm_->NumProc();
   if( 0 == mypid )
     std::cout<<std::endl<<"Entering restart: PID "<<mypid<<" NumProcs "<<numproc<<std::endl<<std::endl;
+
+  //cn only the files of this decomposition can be reopened in place; anything else
+  //cn is read by global node id and redistributed
+  int restart_procs = paramList.get<int> (TusasrestartnumprocNameString);
+  if( 0 == restart_procs ) restart_procs = numproc;
+  if( restart_procs != numproc ){
+    restart_redistribute(u, u_old, restart_procs);
+    return;
+  }
   
   if( 1 == numproc ){//cn for now
     //if( 0 == mypid ){
@@ -2159,6 +2163,99 @@ void ModelEvaluatorNEMESIS<Scalar>::restart(Teuchos::RCP<Epetra_Vector> u,Teucho
 }
 
 
+template<class Scalar>
+void ModelEvaluatorNEMESIS<Scalar>::restart_redistribute(Teuchos::RCP<Epetra_Vector> u,Teuchos::RCP<Epetra_Vector> u_old, const int restart_procs)
+{
+  int mypid = comm_->MyPID();
+  int numproc = comm_->NumProc();
+  if( 0 == mypid )
+    std::cout<<"  Redistributing restart from "<<restart_procs<<" procs to "<<numproc<<" procs"<<std::endl;
+
+  //cn with at least as many files as procs each proc reads whole files; otherwise
+  //cn the procs that share a file each read a range of its nodes
+
+  std::unordered_map<int, int> read_lid;
+  std::vector<int> read_gid;
+  std::vector<double> read_u;
+  int step = -99;
+  double time = -99.99;
+
+  for( int f = 0; f < restart_procs; f++ ){
+    int part = 0;
+    int num_parts = 1;
+    if( restart_procs >= numproc ){
+      if( mypid != f%numproc ) continue;
+    }
+    else{
+      if( f != mypid%restart_procs ) continue;
+      part = mypid/restart_procs;
+      num_parts = (numproc - f + restart_procs - 1)/restart_procs;
+    }
+
+    std::string pfile = "results.e";
+    if( 1 < restart_procs ){
+      std::string fstring = std::to_string(f);
+      fstring = std::string(std::to_string(restart_procs).size() - fstring.size(), '0') + fstring;
+      pfile = "decomp/results.e."+std::to_string(restart_procs)+"."+fstring;
+    }
+    std::cout<<"  Reading restart part "<<part<<" of "<<num_parts<<"; filename = "<<pfile<<std::endl;
+
+    std::vector<int> gids;
+    std::vector<std::vector<double> > data;
+    int error = mesh_->read_nodal_data_exodus(pfile.c_str(), *varnames_, part, num_parts, step, time, gids, data);
+    if( 0 > error ) {
+      std::cout<<"Error reading restart file "<<pfile<<std::endl;
+      exit(0);
+    }
+
+    //cn border nodes are in more than one file
+    for( int i = 0; i < gids.size(); i++ ){
+      if( !read_lid.insert(std::make_pair(gids[i], (int)read_gid.size())).second ) continue;
+      read_gid.push_back(gids[i]);
+      for( int k = 0; k < numeqs_; k++ ) read_u.push_back(data[k][i]);
+    }
+  }
+
+  //cn proc 0 always reads the first file
+  comm_->Broadcast(&step, 1, 0);
+  comm_->Broadcast(&time, 1, 0);
+  if( 0 == mypid )
+    std::cout<<"  Reading restart last step = "<<step<<" time = "<<time<<std::endl;
+
+  std::vector<int> my_global_nodes(numeqs_*read_gid.size());
+  for(int i = 0; i < read_gid.size(); i++){
+    for( int k = 0; k < numeqs_; k++ ){
+      my_global_nodes[numeqs_*i+k] = numeqs_*read_gid[i]+k;
+    }
+  }
+  Epetra_Map read_map(-1,
+		      my_global_nodes.size(),
+		      my_global_nodes.empty() ? NULL : &my_global_nodes[0],
+		      0,
+		      *comm_);
+  Epetra_Vector u_read(Copy, read_map, read_u.empty() ? NULL : &read_u[0]);
+
+  //cn the read layout overlaps on border nodes, so the values are sent to their
+  //cn owners the same way u_temp is in restart
+  Epetra_Export exporter(read_map, *x_owned_map_);
+
+  u->Export(u_read, exporter, Insert);
+  u_old->Export(u_read, exporter, Insert);
+  this->start_time = time;
+  int ntstep = (int)(time/dt_);
+  this->start_step = ntstep+1;
+  time_=time;
+
+  //cn this decomposition gets new results files, which initialize starts with the restart state
+  create_output();
+  output_step_ = 1;
+
+  if( 0 == mypid ){
+    std::cout<<"Restarting at time = "<<time<<" and step = "<<step<<std::endl<<std::endl;
+    std::cout<<"Exiting restart"<<std::endl<<std::endl;
+  }
+}
+
 template<class Scalar>
 void ModelEvaluatorNEMESIS<Scalar>::set_test_case()
 {
@@ -31,8 +31,12 @@
 
 #include "elem_color.h"
 
+#include "insitu_analysis.h"
+
 #include <boost/ptr_container/ptr_vector.hpp>
 
+#include <thread>
+
 template <typename LocalOrdinal,typename GlobalOrdinal>
 class GreedyTieBreak : public Tpetra::Details::TieBreak<LocalOrdinal,GlobalOrdinal> 
 {
@@ -83,7 +87,10 @@ public:
 			   Teuchos::ParameterList plist 
 		       );
   /// Destructor
-  ~ModelEvaluatorTPETRA(){};
+  ~ModelEvaluatorTPETRA(){
+    wait_write_exodus();
+    if( this == io_model_ ) io_model_ = NULL;
+  };
 
   typedef Tpetra::Vector<>::scalar_type scalar_type;
 
@@ -104,12 +111,37 @@ public:
   void finalize();
   void advance();
   void write_exodus();
+  /// Write a binary checkpoint after timestep step when checkpointfreq or checkpointwalltime is due.
+  void checkpoint(const int step);
 
   void evalModelImpl(
 		     const ::Thyra::ModelEvaluatorBase::InArgs<Scalar> &inArgs,
 		     const ::Thyra::ModelEvaluatorBase::OutArgs<Scalar> &outArgs
 		     ) const;
 
+  //cn these need to be public for cuda lambdas
+  /// Residual fill over all colors, with physics supplied by FUNCTOR (see tpetra::heat_functor).
+  template<class FUNCTOR>
+  void fill_residual(const FUNCTOR &functor,
+		     const Teuchos::RCP<Tpetra::Vector<> > &u,
+		     const Teuchos::RCP<Tpetra::Vector<> > &uold,
+		     const Teuchos::RCP<Tpetra::Vector<> > &f_overlap,
+		     const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1dra
+		     ) const;
+  /// Preconditioner fill over all colors, with physics supplied by FUNCTOR.
+  template<class FUNCTOR>
+  void fill_prec(const FUNCTOR &functor,
+		 const Teuchos::RCP<Tpetra::Vector<> > &u,
+		 const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1d
+		 ) const;
+  /// Row sums of the time derivative part of the preconditioner (theta = 0), with physics supplied by FUNCTOR.
+  template<class FUNCTOR>
+  void fill_lumped_mass(const FUNCTOR &functor,
+			const Teuchos::RCP<Tpetra::Vector<> > &u,
+			const Teuchos::RCP<Tpetra::Vector<> > &m_overlap,
+			const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1d
+			) const;
+
 private:
 
   typedef Tpetra::Vector<>::global_ordinal_type global_ordinal_type;
@@ -138,9 +170,13 @@ private:
 
   Mesh* mesh_;
 
-  int update_mesh_data();
+  /// Stage the solution, error estimates and post process variables in mesh_ for output.
+  /** With scalar_data false the post process scalars are not appended to their files. */
+  int update_mesh_data(const bool scalar_data = true);
 
   void restart(Teuchos::RCP<vector_type> u);//,Teuchos::RCP<vector_type> u_old);
+  /// Restart from the results of a run on restart_procs procs (1 is the global results.e), redistributed by global node id.
+  void restart_redistribute(Teuchos::RCP<vector_type> u, const int restart_procs);
 
   void set_test_case();
 
@@ -149,6 +185,14 @@ private:
   int ex_id_;
 
   int output_step_;
+  /// Background exodus writer, used with asyncoutput; it reads only the fields staged in mesh_
+  std::thread io_thread_;
+  /// Wait for the background exodus write, if any, to finish
+  void wait_write_exodus();
+  /// Model whose writer is joined at exit(), which skips the destructor.
+  static ModelEvaluatorTPETRA *io_model_;
+  /// Join the writer of io_model_; registered with std::atexit.
+  static void wait_write_exodus_atexit();
   int numeqs_;
   int num_owned_nodes_;
   int num_overlap_nodes_;
@@ -165,6 +209,8 @@ private:
   Teuchos::RCP<NOX::Solver::Generic> solver_;
 
   Teuchos::RCP<vector_type> u_old_;
+  /// Overlap vector that receives u_old_ for output, allocated on first use.
+  Teuchos::RCP<vector_type> output_overlap_;
 
   Teuchos::RCP<vector_type> x_;
   Teuchos::RCP<vector_type> y_;
@@ -238,6 +284,72 @@ private:
 
   PARAMFUNC paramfunc_;
 
+  /// Fill kernel functor registered for the test case (tpetra::FILL_FUNCTOR); POINTER_FILL uses residualfunc_ and preconfunc_.
+  int fill_functor_;
+  /// Pointer tables for the fallback fill, resolved once in set_test_case().
+  RESFUNC * h_rf_;
+  /// Device copy of h_rf_ (cuda only).
+  RESFUNC * d_rf_;
+  /// Pointer tables for the fallback fill, resolved once in set_test_case().
+  PREFUNC * h_pf_;
+  /// Device copy of h_pf_ (cuda only).
+  PREFUNC * d_pf_;
+  /// LTP quadrature order, read once in the constructor.
+  int ltp_quadrature_order_;
+  /// Connectivity of block 0, copied to a view once in the constructor.
+  Kokkos::View<int*,Kokkos::DefaultExecutionSpace> meshc_1d_;
+  /// Elements of each color, copied to views once in the constructor.
+  std::vector<Kokkos::View<int*,Kokkos::DefaultExecutionSpace> > elem_map_1d_;
+
+  /// Geometry cache: jac*wt per (elem, gp); empty unless geometrycache is set.
+  Kokkos::View<double**,Kokkos::DefaultExecutionSpace> geo_jacwt_;
+  /// Geometry cache: physical coordinates per (elem, gp, dim).
+  Kokkos::View<double***,Kokkos::DefaultExecutionSpace> geo_xyz_;
+  /// Geometry cache: physical basis gradients per (elem, gp, node, dim).
+  Kokkos::View<double****,Kokkos::DefaultExecutionSpace> geo_dphi_;
+  /// Fill the geometry cache for block 0 at the LTP quadrature order.
+  void compute_geometry_cache();
+  /// Pass outputdigits to the nodal fields of mesh_; after they are added
+  void set_output_digits();
+  /// Create the results file(s) for this decomposition: results.e in serial or with globaloutput, per proc files otherwise.
+  /** With append the existing files are reopened instead. */
+  void create_output(const bool append = false);
+  /// Suffix of proc pid in the names of per proc files of a run on numproc procs.
+  /** Zero padded to the width of numproc, as nem_spread and epu expect. */
+  std::string proc_string(const int pid, const int numproc) const;
+  /// Write u_old_, time, timestep, dt and output step to this proc's checkpoint file.
+  void write_checkpoint(const int step);
+  /// Fill u from the checkpoint files of a run on restart_procs procs, redistributed by global node id.
+  void read_checkpoint(Teuchos::RCP<vector_type> u, const int restart_procs);
+  /// Checkpoint file of proc pid of a run on numproc procs; next to the results files.
+  std::string checkpoint_file(const int pid, const int numproc) const;
+  /// Wall time of the last checkpoint, or of the start of the run.
+  double checkpoint_time_;
+
+  /// Explicit time integrator: none, euler, rk2 or rk3.
+  std::string explicit_method_;
+  /// True if the time derivative of one equation appears in the residual of another (farzadi).
+  bool coupled_mass_;
+  /// Reciprocal of the lumped mass (including 1/dt); unity on Dirichlet rows.
+  Teuchos::RCP<vector_type> inv_lumped_mass_;
+  /// Compute inv_lumped_mass_ from u_old_.
+  void compute_lumped_mass();
+  /// Forward Euler update of u_old_ with the lumped mass, over frac*dt_.
+  void explicit_stage(const double frac = 1.);
+  /// Explicit replacement for the NOX solve in advance().
+  void advance_explicit();
+
+  /// Explicit substeps per timestep for each equation; 0 is implicit.
+  std::vector<int> subcycle_;
+  /// True if any equation is sub-cycled.
+  bool split_;
+  /// True while a split stage is evaluated; rows of inactive equations are held.
+  bool split_stage_;
+  /// Equations advanced in the current split stage.
+  std::vector<bool> eqn_active_;
+  /// Sub-cycle the equations with subcycle_[k] > 0.
+  void advance_subcycle();
+
   RCP<Teuchos::Time> ts_time_import;
   RCP<Teuchos::Time> ts_time_resfill;
   RCP<Teuchos::Time> ts_time_precfill;
@@ -257,6 +369,24 @@ private:
   boost::ptr_vector<error_estimator> Error_est;
   boost::ptr_vector<post_process> post_proc;
   void postprocess();
+  /// In situ reductions, when insitu lists any equations.
+  Teuchos::RCP<insitu_analysis> insitu_;
+  /// Timestep index for the in situ reductions and region output.
+  int analysis_step_;
+  /// Solution on the overlap map: u_old_ in serial, otherwise imported into output_overlap_.
+  Teuchos::RCP<const vector_type> get_overlap_solution();
+  /// Write the elements passing the region filters to the region side file; collective.
+  void write_region();
+  /// Exodus id of the current region side file, -1 before the first write.
+  int region_ex_id_;
+  /// Next timestep index in the current region side file.
+  int region_step_;
+  /// Number of region side files started so far.
+  int region_series_;
+  /// Name of region side file number series for proc pid of a run on numproc procs: region.e, region.e-s.0002, ...
+  std::string region_file(const int series, const int pid, const int numproc) const;
+  /// Local ids of the elements in the current region side file.
+  std::vector<int> region_elems_;
 
 };
 
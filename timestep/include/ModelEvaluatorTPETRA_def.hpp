@@ -14,6 +14,7 @@
 #include <Teuchos_Describable.hpp>
 #include <Teuchos_ArrayViewDecl.hpp>
 #include <Teuchos_TimeMonitor.hpp>
+#include <Teuchos_CommHelpers.hpp>
 #include <Teuchos_ParameterList.hpp>
 #include <Teuchos_XMLParameterListCoreHelpers.hpp>
 #include "Teuchos_AbstractFactoryStd.hpp"
@@ -42,6 +43,9 @@
 #include <Stratimikos_MueLuHelpers.hpp>
 
 //#include <string>
+#include <cstdio>
+#include <fstream>
+#include <limits>
 
 
 #define TUSAS_RUN_ON_CPU
@@ -61,6 +65,9 @@ modelEvaluatorTPETRA( const Teuchos::RCP<const Epetra_Comm>& comm,
   return Teuchos::rcp(new ModelEvaluatorTPETRA<Scalar>(mesh,plist));
 }
 
+template<class Scalar>
+ModelEvaluatorTPETRA<Scalar> *ModelEvaluatorTPETRA<Scalar>::io_model_ = NULL;
+
 // Constructor
 
 template<class Scalar>
@@ -74,11 +81,66 @@ ModelEvaluatorTPETRA( const Teuchos::RCP<const Epetra_Comm>& comm,
   Comm(comm)
 {
   dt_ = paramList.get<double> (TusasdtNameString);
+  checkpoint_time_ = Teuchos::Time::wallTime();
   t_theta_ = paramList.get<double> (TusasthetaNameString);
 
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+
+  ltp_quadrature_order_ = paramList.get<int> (TusasltpquadordNameString);
+  if (4 <  ltp_quadrature_order_ ){
+      if( 0 == comm_->getRank() ){
+	std::cout<<std::endl<<std::endl<<"4 <  LTP_quadrature_order" <<std::endl<<std::endl<<std::endl;
+      }
+      exit(0);
+  }
+
+  explicit_method_ = paramList.get<std::string> (TusasexplicitNameString);
+  if( "none" != explicit_method_ ){
+    if( "euler" != explicit_method_ && "rk2" != explicit_method_ && "rk3" != explicit_method_ ){
+      if( 0 == comm_->getRank() ){
+	std::cout<<std::endl<<std::endl<<"Explicit method: "<<explicit_method_
+		 <<" not found; use none, euler, rk2 or rk3." <<std::endl<<std::endl<<std::endl;
+      }
+      exit(0);
+    }
+  }
+
   set_test_case();
 
-  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  //cn the lumped mass is diagonal per equation, so the phi_t term in the farzadi u equation
+  //cn would be dropped
+  if( "none" != explicit_method_ && coupled_mass_ ){
+    if( 0 == comm_->getRank() ){
+      std::cout<<std::endl<<std::endl<<"Explicit method: "<<explicit_method_
+	       <<" cannot be used with testcase "<<paramList.get<std::string> (TusastestNameString)
+	       <<", which couples time derivatives across equations." <<std::endl<<std::endl<<std::endl;
+    }
+    exit(0);
+  }
+
+  subcycle_ = (Teuchos::getArrayFromStringParameter<int>(paramList,
+							 TusassubcycleNameString)).toVector();
+  split_ = false;
+  split_stage_ = false;
+  if( 0 < subcycle_.size() ){
+    if( numeqs_ != (int)subcycle_.size() || "none" != explicit_method_ ){
+      if( 0 == comm_->getRank() ){
+	std::cout<<std::endl<<std::endl<<"subcycle needs one entry per equation and cannot be used with explicit." <<std::endl<<std::endl<<std::endl;
+      }
+      exit(0);
+    }
+    for( int k = 0; k < numeqs_; k++ ) if( 0 < subcycle_[k] ) split_ = true;
+    //cn a held equation would see the substepped time derivative of another as zero
+    if( split_ && coupled_mass_ ){
+      if( 0 == comm_->getRank() ){
+	std::cout<<std::endl<<std::endl<<"subcycle cannot be used with testcase "<<paramList.get<std::string> (TusastestNameString)
+		 <<", which couples time derivatives across equations." <<std::endl<<std::endl<<std::endl;
+      }
+      exit(0);
+    }
+  }
+  eqn_active_ = std::vector<bool>(numeqs_,true);
+
   //comm_->describe(*(Teuchos::VerboseObjectBase::getDefaultOStream()),Teuchos::EVerbosityLevel::VERB_EXTREME );
   
   //mesh_ = Teuchos::rcp(new Mesh(*mesh));
@@ -146,7 +208,7 @@ ModelEvaluatorTPETRA( const Teuchos::RCP<const Epetra_Comm>& comm,
   x0_->putScalar(Teuchos::ScalarTraits<scalar_type>::zero());
 
   bool precon = paramList.get<bool> (TusaspreconNameString);
-  if(precon){
+  if(precon && "none" == explicit_method_){
     // Initialize the graph for W CrsMatrix object
     W_graph_ = createGraph();
     W_overlap_graph_ = createOverlapGraph();
@@ -203,9 +265,40 @@ ModelEvaluatorTPETRA( const Teuchos::RCP<const Epetra_Comm>& comm,
   //there are some epetra_maps and a routine that does mpi calls for off proc comm const 
   //Comm = Teuchos::rcp(new Epetra_MpiComm( MPI_COMM_WORLD ));
   bool dorestart = paramList.get<bool> (TusasrestartNameString);
-  Elem_col = Teuchos::rcp(new elem_color(Comm,mesh,dorestart));
+  Elem_col = Teuchos::rcp(new elem_color(Comm,mesh,dorestart,
+					 paramList.get<bool> (TusascolorcontiguousNameString),
+					 paramList.get<std::string> (TusascolorcacheNameString)));
+
+  //cn connectivity and color lists are copied to views once here, the fills reuse them
+  {
+    const int blk = 0;
+    const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
+    meshc_1d_ = Kokkos::View<int*,Kokkos::DefaultExecutionSpace>("meshc_1d",mesh_->get_num_elem_in_blk(blk)*n_nodes_per_elem);
+    for(int ne = 0; ne < mesh_->get_num_elem_in_blk(blk); ne++) {
+      for(int k = 0; k < n_nodes_per_elem; k++) meshc_1d_(ne*n_nodes_per_elem+k) = mesh_->get_node_id(blk, ne, k);
+    }
+  }
 
-  init_nox();
+  //cn with contiguous colors the fills index elems directly and the views stay empty
+  const int num_color = Elem_col->get_num_color();
+  for(int c = 0; c < num_color; c++){
+    if(-1 < Elem_col->get_color_begin(c)){
+      elem_map_1d_.push_back(Kokkos::View<int*,Kokkos::DefaultExecutionSpace>("elem_map_1d",0));
+      continue;
+    }
+    std::vector<int> elem_map = Elem_col->get_color(c);
+    const int num_elem = elem_map.size();
+    Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d("elem_map_1d",num_elem);
+    for(int i = 0; i<num_elem; i++) {
+      elem_map_1d(i) = elem_map[i]; 
+    }
+    elem_map_1d_.push_back(elem_map_1d);
+  }
+
+  if( paramList.get<bool> (TusasgeometrycacheNameString) ) compute_geometry_cache();
+
+  nnewt_=0;
+  if( "none" == explicit_method_ ) init_nox();
 
   std::vector<int> indices = (Teuchos::getArrayFromStringParameter<int>(paramList,
 								       TusaserrorestimatorNameString)).toVector();
@@ -325,38 +418,38 @@ void ModelEvaluatorTPETRA<Scalar>::set_x0(const Teuchos::ArrayView<const Scalar>
   x0_->get1dViewNonConst()().assign(x0_in);
 }
 
-template<class Scalar>
-void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
-  const Thyra::ModelEvaluatorBase::InArgs<Scalar> &inArgs,
-  const Thyra::ModelEvaluatorBase::OutArgs<Scalar> &outArgs
-  ) const
-{  
-
-  //cn the easiest way probably to do the sum into off proc nodes is to load a 
-  //vector(overlap_map) the export with summation to the f_vec(owned_map)
-  //after summing into. ie import is uniquely-owned to multiply-owned
-  //export is multiply-owned to uniquely-owned
-
-  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
-
-  typedef Thyra::TpetraOperatorVectorExtraction<Scalar,int> ConverterT;
-
-  const Teuchos::RCP<const vector_type > x_vec =
-    ConverterT::getConstTpetraVector(inArgs.get_x());
-
-  Teuchos::RCP<vector_type > u = Teuchos::rcp(new vector_type(x_overlap_map_));
-  Teuchos::RCP<vector_type > uold = Teuchos::rcp(new vector_type(x_overlap_map_));
-  {
-    Teuchos::TimeMonitor ImportTimer(*ts_time_import);
-    u->doImport(*x_vec,*importer_,Tpetra::INSERT);
-    uold->doImport(*u_old_,*importer_,Tpetra::INSERT);
+//cn loads the cached geometry of elem at gp into B, then evaluates u and uold
+template<class JACWT, class XYZ, class DPHI>
+KOKKOS_INLINE_FUNCTION
+void get_basis_cached(GPUBasis *B, const int elem, const int gp, const int n, const int num_dim,
+		      const JACWT &geo_jacwt, const XYZ &geo_xyz, const DPHI &geo_dphi,
+		      const double *u, const double *uold)
+{
+  B->jac = geo_jacwt(elem,gp);
+  B->wt = 1.;
+  B->xx = geo_xyz(elem,gp,0);
+  B->yy = geo_xyz(elem,gp,1);
+  B->zz = (3 == num_dim) ? geo_xyz(elem,gp,2) : 0.;
+  for(int i = 0; i < n; i++){
+    B->dphidx[i] = geo_dphi(elem,gp,i,0);
+    B->dphidy[i] = geo_dphi(elem,gp,i,1);
+    B->dphidz[i] = (3 == num_dim) ? geo_dphi(elem,gp,i,2) : 0.;
   }
+  B->getBasisCached(gp, n, u, uold);
+}
 
+template<class Scalar>
+template<class FUNCTOR>
+void ModelEvaluatorTPETRA<Scalar>::fill_residual(const FUNCTOR &functor,
+						 const Teuchos::RCP<vector_type> &u,
+						 const Teuchos::RCP<vector_type> &uold,
+						 const Teuchos::RCP<vector_type> &f_overlap,
+						 const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1dra
+						 ) const
+{
   auto x_view = x_->getLocalView<Kokkos::DefaultExecutionSpace>();
   auto y_view = y_->getLocalView<Kokkos::DefaultExecutionSpace>();
   auto z_view = z_->getLocalView<Kokkos::DefaultExecutionSpace>();
-  //using RandomAccess should give better memory performance on better than tesla gpus (guido is tesla and does not show performance increase)
-  //this will utilize texture memory not available on tesla or earlier gpus
   Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> x_1dra = Kokkos::subview (x_view, Kokkos::ALL (), 0);
   Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> y_1dra = Kokkos::subview (y_view, Kokkos::ALL (), 0);
   Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> z_1dra = Kokkos::subview (z_view, Kokkos::ALL (), 0);
@@ -365,109 +458,37 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
   Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> 
     u_1dra = Kokkos::subview (u_view, Kokkos::ALL (), 0);
 
+  auto uold_view = uold->getLocalView<Kokkos::DefaultExecutionSpace>();
+  //using RandomAccess should give better memory performance on better than tesla gpus (guido is tesla and does not show performance increase)
+  //this will utilize texture memory not available on tesla or earlier gpus
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> 
+    uold_1dra = Kokkos::subview (uold_view, Kokkos::ALL (), 0);
+
+  auto f_view = f_overlap->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto f_1d = Kokkos::subview (f_view, Kokkos::ALL (), 0);
+
   const int blk = 0;
   const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);//shared
   const int num_color = Elem_col->get_num_color();
 
-  Kokkos::View<int*,Kokkos::DefaultExecutionSpace> meshc_1d("meshc_1d",((mesh_->connect)[0]).size());
-
-
-  Kokkos::View<int**,Kokkos::DefaultExecutionSpace> meshc_2d("meshc_2d",n_nodes_per_elem,(*mesh_->get_elem_num_map()).size());
-
-  //std::cout<<n_nodes_per_elem*(*mesh_->get_elem_num_map()).size()<<"  "<<((mesh_->connect)[0]).size()<<std::endl;
-
-  //Kokkos::vector<int> meshc(((mesh_->connect)[0]).size());
-  for(int i = 0; i<((mesh_->connect)[0]).size(); i++) {
-    meshc_1d(i)=(mesh_->connect)[0][i];
-  }
-  Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> meshc_1dra(meshc_1d);
-
   const double dt = dt_; //cuda 8 lambdas dont capture private data
   const double t_theta = t_theta_; //cuda 8 lambdas dont capture private data
   const double time = time_; //cuda 8 lambdas dont capture private data
   const int numeqs = numeqs_; //cuda 8 lambdas dont capture private data
-  const int LTP_quadrature_order = paramList.get<int> (TusasltpquadordNameString);
-  if (4 <  LTP_quadrature_order ){
-      if( 0 == comm_->getRank() ){
-	std::cout<<std::endl<<std::endl<<"4 <  LTP_quadrature_order" <<std::endl<<std::endl<<std::endl;
-      }
-      exit(0);
-  }
-  
-  if (nonnull(outArgs.get_f())){
-
-    const RCP<vector_type> f_vec =
-      ConverterT::getTpetraVector(outArgs.get_f());
-
-    Teuchos::RCP<vector_type> f_overlap = Teuchos::rcp(new vector_type(x_overlap_map_));
-    f_vec->scale(0.);
-    f_overlap->scale(0.);
-    Teuchos::TimeMonitor ResFillTimer(*ts_time_resfill);  
-
-//     std::string elem_type=mesh_->get_blk_elem_type(blk);
-//     std::string * elem_type_p = &elem_type;
-
-    auto uold_view = uold->getLocalView<Kokkos::DefaultExecutionSpace>();
-    
-    auto f_view = f_overlap->getLocalView<Kokkos::DefaultExecutionSpace>();
-        
-    auto f_1d = Kokkos::subview (f_view, Kokkos::ALL (), 0);
-    //Kokkos::View<double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> f_1d = Kokkos::subview (f_view, Kokkos::ALL (), 0);
-
-    //using RandomAccess should give better memory performance on better than tesla gpus (guido is tesla and does not show performance increase)
-    //this will utilize texture memory not available on tesla or earlier gpus
-    Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> 
-      uold_1dra = Kokkos::subview (uold_view, Kokkos::ALL (), 0);
-
-    RESFUNC * h_rf;
-    h_rf = (RESFUNC*)malloc(numeqs_*sizeof(RESFUNC));
-
-#ifdef KOKKOS_HAVE_CUDA
-    RESFUNC * d_rf;
-    cudaMalloc((double**)&d_rf,numeqs_*sizeof(RESFUNC));
-
-    if("heat" == paramList.get<std::string> (TusastestNameString)){
-      //cn this will need to be done for each equation
-      cudaMemcpyFromSymbol( &h_rf[0], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
-    }else if("heat2" == paramList.get<std::string> (TusastestNameString)){
-      cudaMemcpyFromSymbol( &h_rf[0], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
-      cudaMemcpyFromSymbol( &h_rf[1], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
-    }else if("farzadi" == paramList.get<std::string> (TusastestNameString)){
-      cudaMemcpyFromSymbol( &h_rf[0], tpetra::farzadi3d::residual_conc_farzadi_dp_, sizeof(RESFUNC));
-      cudaMemcpyFromSymbol( &h_rf[1], tpetra::farzadi3d::residual_phase_farzadi_dp_, sizeof(RESFUNC));
-
-
-    } else {
-      if( 0 == comm_->getRank() ){
-	std::cout<<std::endl<<std::endl<<"Test case: "<<paramList.get<std::string> (TusastestNameString)
-		 <<" residual function not found. (void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(...))" <<std::endl<<std::endl<<std::endl;
-      }
-      exit(0);
-    }
-
-    cudaMemcpy(d_rf,h_rf,numeqs_*sizeof(RESFUNC),cudaMemcpyHostToDevice);
-
-#else
-    //it seems that evaluating the function via pointer ie h_rf[0] is way faster that evaluation via (*residualfunc_)[0]
-    h_rf = &(*residualfunc_)[0];
-#endif
+  const int LTP_quadrature_order = ltp_quadrature_order_;
 
+  //cn the geometry cache is used when it was built at the quadrature order of the fill
+  const Kokkos::View<double**,Kokkos::DefaultExecutionSpace> geo_jacwt = geo_jacwt_;
+  const Kokkos::View<double***,Kokkos::DefaultExecutionSpace> geo_xyz = geo_xyz_;
+  const Kokkos::View<double****,Kokkos::DefaultExecutionSpace> geo_dphi = geo_dphi_;
+  const int geo_ngp = geo_jacwt_.extent(1);
+  const int num_dim = mesh_->get_num_dim();
 
     for(int c = 0; c < num_color; c++){
-      //std::vector<int> elem_map = colors[c];
-      std::vector<int> elem_map = Elem_col->get_color(c);
 
-      const int num_elem = elem_map.size();
-
-      Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d("elem_map_1d",num_elem);
-      //Kokkos::vector<int> elem_map_k(num_elem);
-      for(int i = 0; i<num_elem; i++) {
-	//elem_map_k[i] = elem_map[i]; 
-	elem_map_1d(i) = elem_map[i]; 
-      }
-      //exit(0);
-      //auto elem_map_2d = Kokkos::subview(elem_map_1d, Kokkos::ALL (), Kokkos::ALL (), 0);
-      //std::cout<<elem_map_2d.extent(0)<<"   "<<elem_map_2d.extent(1)<<std::endl;
+      Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d = elem_map_1d_[c];
+      const int elem_begin = Elem_col->get_color_begin(c);
+      const int num_elem = (0 > elem_begin) ? elem_map_1d.extent(0) : Elem_col->get_color_begin(c+1) - elem_begin;
  
       //for (int ne=0; ne < num_elem; ne++) { 
       //#define USE_TEAM
@@ -480,26 +501,19 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
       int num_teams = (num_elem/team_size)+1;//this is # of thread teams (also league size); unlimited
       Kokkos::View<const int*,Kokkos::DefaultExecutionSpace> elem_map_1dConst(elem_map_1d);
 
-//       int strides[1]; // any integer type works in stride()
-//       elem_map_1dConst.stride (strides);
-//       std::cout<<strides[0]<<std::endl;
-
-
       typedef Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace>::member_type member_type;
 
       //TeamPolicy <ExecutionSpace >( numberOfTeams , teamSize)
       Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace> policy (num_teams, team_size );
-      //std::cout<<policy.league_size()<<"    "<<policy.team_size()<<std::endl;
       Kokkos::parallel_for (policy, KOKKOS_LAMBDA (member_type team_member) {
         // Calculate a global thread id
         int ne = team_member.league_rank () * team_member.team_size () +
                 team_member.team_rank ();
 	if(ne < num_elem) {
-	  const int elem = elem_map_1dConst(ne);
+	  const int elem = (0 > elem_begin) ? elem_map_1dConst(ne) : elem_begin+ne;
 #else
 	  Kokkos::parallel_for(num_elem,KOKKOS_LAMBDA(const size_t ne){//this loop is fine for openmp re access to elem_map
-			     //for(int ne =0; ne<num_elem; ne++){
-	const int elem = elem_map_1d(ne);
+	const int elem = (0 > elem_begin) ? elem_map_1d(ne) : elem_begin+ne;
 #endif
 
 	GPUBasis * BGPU[TUSAS_MAX_NUMEQS];
@@ -515,6 +529,7 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
 	}
 	
 	const int ngp = BGPU[0]->ngp;
+	const bool use_geo = (geo_ngp == ngp);
 
 	double xx[BASIS_NODES_PER_ELEM];
 	double yy[BASIS_NODES_PER_ELEM];
@@ -527,67 +542,361 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
 
 	for(int k = 0; k < n_nodes_per_elem; k++){
 	  
-	  //meshc is a kokkos::vector, not sure how efficient this is
-	  //maybe a view is better?
-	  //const int nodeid = meshc[elemrow+k];//cn this is the local id
 	  const int nodeid = meshc_1dra(elemrow+k);//cn this is the local id
 	  
-	  xx[k] = x_1dra(nodeid);
-	  yy[k] = y_1dra(nodeid);
-	  zz[k] = z_1dra(nodeid);
+	  if( !use_geo ){
+	    xx[k] = x_1dra(nodeid);
+	    yy[k] = y_1dra(nodeid);
+	    zz[k] = z_1dra(nodeid);
+	  }
 
 	  for( int neq = 0; neq < numeqs; neq++ ){
-	    //std::cout<<numeqs*k+neq<<"           "<<n_nodes_per_elem*neq+k <<"      "<<nodeid<<"    "<<numeqs_*nodeid+neq<<std::endl;
-
 	    uu[n_nodes_per_elem*neq+k] = u_1dra(numeqs*nodeid+neq); 
 	    uu_old[n_nodes_per_elem*neq+k] = uold_1dra(numeqs*nodeid+neq);
 	  }//neq
 	}//k
 
-	for( int neq = 0; neq < numeqs; neq++ ){
-	  BGPU[neq]->computeElemData(&xx[0], &yy[0], &zz[0]);
-	//(&BGPUarr[0])->computeElemData(&xx[0], &yy[0], &zz[0]);
-	}//neq
+	if( !use_geo ){
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    BGPU[neq]->computeElemData(&xx[0], &yy[0], &zz[0]);
+	  }//neq
+	}
 	for(int gp=0; gp < ngp; gp++) {//gp
 
 	  for( int neq = 0; neq < numeqs; neq++ ){
 	    //we need a basis object that stores all equations here..
-	    BGPU[neq]->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[neq*n_nodes_per_elem], &uu_old[neq*n_nodes_per_elem],NULL);
+	    if( use_geo ){
+	      get_basis_cached(BGPU[neq], elem, gp, n_nodes_per_elem, num_dim, geo_jacwt, geo_xyz, geo_dphi,
+			       &uu[neq*n_nodes_per_elem], &uu_old[neq*n_nodes_per_elem]);
+	    }else{
+	      BGPU[neq]->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[neq*n_nodes_per_elem], &uu_old[neq*n_nodes_per_elem],NULL);
+	    }
 	  }//neq
 	  const double jacwt = BGPU[0]->jac*BGPU[0]->wt;
 	  for (int i=0; i< n_nodes_per_elem; i++) {//i
 
-	    //const int lrow = numeqs*meshc[elemrow+i];
-	    const int lrow = numeqs*meshc_1dra(elemrow+i);
+	    const int lrow = numeqs*meshc_1dra(elemrow+i);
+
+	    for( int neq = 0; neq < numeqs; neq++ ){
+	      const double val = jacwt*(functor.residual(*BGPU,i,dt,t_theta,time,neq));
+	      //cn this works because we are filling an overlap map and exporting to a node map below...
+	      const int lid = lrow+neq;
+	      f_1d[lid] += val;
+	    }//neq
+	  }//i
+	}//gp
+#ifdef USE_TEAM
+			       }//if ne
+#else
+#endif
+      });//parallel_for
+		     //};//ne
+
+    }//c 
+}
+
+template<class Scalar>
+template<class FUNCTOR>
+void ModelEvaluatorTPETRA<Scalar>::fill_prec(const FUNCTOR &functor,
+					     const Teuchos::RCP<vector_type> &u,
+					     const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1d
+					     ) const
+{
+  auto x_view = x_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto y_view = y_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto z_view = z_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> x_1dra = Kokkos::subview (x_view, Kokkos::ALL (), 0);
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> y_1dra = Kokkos::subview (y_view, Kokkos::ALL (), 0);
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> z_1dra = Kokkos::subview (z_view, Kokkos::ALL (), 0);
+
+  auto u_view = u->getLocalView<Kokkos::DefaultExecutionSpace>();
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> 
+    u_1dra = Kokkos::subview (u_view, Kokkos::ALL (), 0);
+
+  auto PV = P->getLocalMatrix();//this is a KokkosSparse::CrsMatrix<scalar_type,local_ordinal_type, node_type> PV = P->getLocalMatrix();
+
+  const int blk = 0;
+  const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);//shared
+  const int num_color = Elem_col->get_num_color();
+
+  const double dt = dt_; //cuda 8 lambdas dont capture private data
+  const double t_theta = t_theta_; //cuda 8 lambdas dont capture private data
+  const int numeqs = numeqs_; //cuda 8 lambdas dont capture private data
+
+  //cn the geometry cache is used when it was built at the quadrature order of the fill
+  const Kokkos::View<double**,Kokkos::DefaultExecutionSpace> geo_jacwt = geo_jacwt_;
+  const Kokkos::View<double***,Kokkos::DefaultExecutionSpace> geo_xyz = geo_xyz_;
+  const Kokkos::View<double****,Kokkos::DefaultExecutionSpace> geo_dphi = geo_dphi_;
+  const int geo_ngp = geo_jacwt_.extent(1);
+  const int num_dim = mesh_->get_num_dim();
+
+    for(int c = 0; c < num_color; c++){
+
+      Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d = elem_map_1d_[c];
+      const int elem_begin = Elem_col->get_color_begin(c);
+      const int num_elem = (0 > elem_begin) ? elem_map_1d.extent(0) : Elem_col->get_color_begin(c+1) - elem_begin;
+
+      Kokkos::parallel_for(num_elem,KOKKOS_LAMBDA(const size_t ne){
+
+	const int elem = (0 > elem_begin) ? elem_map_1d(ne) : elem_begin+ne;
+
+	GPUBasis * BGPU[TUSAS_MAX_NUMEQS];
+	
+	GPUBasisLQuad Bq[TUSAS_MAX_NUMEQS];
+	GPUBasisLHex Bh[TUSAS_MAX_NUMEQS];
+	if(4 == n_nodes_per_elem)  {
+	  for( int neq = 0; neq < numeqs; neq++ )
+	    BGPU[neq] = &Bq[neq];
+	}else{
+	  for( int neq = 0; neq < numeqs; neq++ )
+	    BGPU[neq] = &Bh[neq];
+	}
+	
+	const int ngp = BGPU[0]->ngp;
+	const bool use_geo = (geo_ngp == ngp);
+
+	double xx[BASIS_NODES_PER_ELEM];
+	double yy[BASIS_NODES_PER_ELEM];
+	double zz[BASIS_NODES_PER_ELEM];
+	double uu[TUSAS_MAX_NUMEQS_X_BASIS_NODES_PER_ELEM];
+
+	const int elemrow = elem*n_nodes_per_elem;
+
+	for(int k = 0; k < n_nodes_per_elem; k++){
+	  
+	  const int nodeid = meshc_1d(elemrow+k);
+	  
+	  if( !use_geo ){
+	    xx[k] = x_1dra(nodeid);
+	    yy[k] = y_1dra(nodeid);
+	    zz[k] = z_1dra(nodeid);
+	  }
+
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    uu[n_nodes_per_elem*neq+k] = u_1dra(numeqs*nodeid+neq); 
+	  }//neq
+	}//k
+
+	if( !use_geo ){
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    BGPU[neq]->computeElemData(&xx[0], &yy[0], &zz[0]);
+	  }//neq
+	}
+
+	for(int gp=0; gp < ngp; gp++) {//gp
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    if( use_geo ){
+	      get_basis_cached(BGPU[neq], elem, gp, n_nodes_per_elem, num_dim, geo_jacwt, geo_xyz, geo_dphi,
+			       &uu[neq*n_nodes_per_elem], NULL);
+	    }else{
+	      BGPU[neq]->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[neq*n_nodes_per_elem], NULL,NULL);
+	    }
+	  }//neq
+	  const double jacwt = BGPU[0]->jac*BGPU[0]->wt;
+	  for (int i=0; i< n_nodes_per_elem; i++) {//i
+	    const local_ordinal_type lrow = numeqs*meshc_1d(elemrow+i);
+	    for(int j=0;j < n_nodes_per_elem; j++) {
+	      local_ordinal_type lcol[1] = {numeqs*meshc_1d(elemrow+j)};
+	      
+	      for( int neq = 0; neq < numeqs; neq++ ){
+		scalar_type val[1] = {jacwt*functor.precon(*BGPU,i,j,dt,t_theta,neq)};
+		
+		//cn probably better to fill a view for val and lcol for each column
+		const local_ordinal_type row = lrow +neq; 
+		local_ordinal_type col[1] = {lcol[0] + neq};
+		
+		PV.sumIntoValues (row, col,(local_ordinal_type)1,val);
+		
+	      }//neq
+	      
+	    }//j
+	    
+	  }//i
+
+	}//gp
+
+      });//parallel_for
+
+    }//c
+}
+
+template<class Scalar>
+template<class FUNCTOR>
+void ModelEvaluatorTPETRA<Scalar>::fill_lumped_mass(const FUNCTOR &functor,
+						    const Teuchos::RCP<vector_type> &u,
+						    const Teuchos::RCP<vector_type> &m_overlap,
+						    const Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> &meshc_1d
+						    ) const
+{
+  auto x_view = x_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto y_view = y_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto z_view = z_->getLocalView<Kokkos::DefaultExecutionSpace>();
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> x_1dra = Kokkos::subview (x_view, Kokkos::ALL (), 0);
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> y_1dra = Kokkos::subview (y_view, Kokkos::ALL (), 0);
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> z_1dra = Kokkos::subview (z_view, Kokkos::ALL (), 0);
+
+  auto u_view = u->getLocalView<Kokkos::DefaultExecutionSpace>();
+  Kokkos::View<const double*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> 
+    u_1dra = Kokkos::subview (u_view, Kokkos::ALL (), 0);
+
+  auto m_view = m_overlap->getLocalView<Kokkos::DefaultExecutionSpace>();
+  auto m_1d = Kokkos::subview (m_view, Kokkos::ALL (), 0);
+
+  const int blk = 0;
+  const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);//shared
+  const int num_color = Elem_col->get_num_color();
+
+  const double dt = dt_; //cuda 8 lambdas dont capture private data
+  const double t_theta = 0.; //cn only the time derivative part of PREFUNC
+  const int numeqs = numeqs_; //cuda 8 lambdas dont capture private data
+
+  //cn the geometry cache is used when it was built at the quadrature order of the fill
+  const Kokkos::View<double**,Kokkos::DefaultExecutionSpace> geo_jacwt = geo_jacwt_;
+  const Kokkos::View<double***,Kokkos::DefaultExecutionSpace> geo_xyz = geo_xyz_;
+  const Kokkos::View<double****,Kokkos::DefaultExecutionSpace> geo_dphi = geo_dphi_;
+  const int geo_ngp = geo_jacwt_.extent(1);
+  const int num_dim = mesh_->get_num_dim();
+
+    for(int c = 0; c < num_color; c++){
+
+      Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d = elem_map_1d_[c];
+      const int elem_begin = Elem_col->get_color_begin(c);
+      const int num_elem = (0 > elem_begin) ? elem_map_1d.extent(0) : Elem_col->get_color_begin(c+1) - elem_begin;
+
+      Kokkos::parallel_for(num_elem,KOKKOS_LAMBDA(const size_t ne){
+
+	const int elem = (0 > elem_begin) ? elem_map_1d(ne) : elem_begin+ne;
+
+	GPUBasis * BGPU[TUSAS_MAX_NUMEQS];
+	
+	GPUBasisLQuad Bq[TUSAS_MAX_NUMEQS];
+	GPUBasisLHex Bh[TUSAS_MAX_NUMEQS];
+	if(4 == n_nodes_per_elem)  {
+	  for( int neq = 0; neq < numeqs; neq++ )
+	    BGPU[neq] = &Bq[neq];
+	}else{
+	  for( int neq = 0; neq < numeqs; neq++ )
+	    BGPU[neq] = &Bh[neq];
+	}
+	
+	const int ngp = BGPU[0]->ngp;
+	const bool use_geo = (geo_ngp == ngp);
+
+	double xx[BASIS_NODES_PER_ELEM];
+	double yy[BASIS_NODES_PER_ELEM];
+	double zz[BASIS_NODES_PER_ELEM];
+	double uu[TUSAS_MAX_NUMEQS_X_BASIS_NODES_PER_ELEM];
+
+	const int elemrow = elem*n_nodes_per_elem;
+
+	for(int k = 0; k < n_nodes_per_elem; k++){
+	  
+	  const int nodeid = meshc_1d(elemrow+k);
+	  
+	  if( !use_geo ){
+	    xx[k] = x_1dra(nodeid);
+	    yy[k] = y_1dra(nodeid);
+	    zz[k] = z_1dra(nodeid);
+	  }
+
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    uu[n_nodes_per_elem*neq+k] = u_1dra(numeqs*nodeid+neq); 
+	  }//neq
+	}//k
+
+	if( !use_geo ){
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    BGPU[neq]->computeElemData(&xx[0], &yy[0], &zz[0]);
+	  }//neq
+	}
+
+	for(int gp=0; gp < ngp; gp++) {//gp
+	  for( int neq = 0; neq < numeqs; neq++ ){
+	    if( use_geo ){
+	      get_basis_cached(BGPU[neq], elem, gp, n_nodes_per_elem, num_dim, geo_jacwt, geo_xyz, geo_dphi,
+			       &uu[neq*n_nodes_per_elem], NULL);
+	    }else{
+	      BGPU[neq]->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[neq*n_nodes_per_elem], NULL,NULL);
+	    }
+	  }//neq
+	  const double jacwt = BGPU[0]->jac*BGPU[0]->wt;
+	  for (int i=0; i< n_nodes_per_elem; i++) {//i
+	    const local_ordinal_type lrow = numeqs*meshc_1d(elemrow+i);
+	    for(int j=0;j < n_nodes_per_elem; j++) {
+	      for( int neq = 0; neq < numeqs; neq++ ){
+		//cn row sum; this works because we are filling an overlap map and exporting to a node map
+		m_1d[lrow+neq] += jacwt*functor.precon(*BGPU,i,j,dt,t_theta,neq);
+	      }//neq
+	    }//j
+	    
+	  }//i
+
+	}//gp
+
+      });//parallel_for
+
+    }//c
+}
+
+
+template<class Scalar>
+void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
+  const Thyra::ModelEvaluatorBase::InArgs<Scalar> &inArgs,
+  const Thyra::ModelEvaluatorBase::OutArgs<Scalar> &outArgs
+  ) const
+{  
+
+  //cn the easiest way probably to do the sum into off proc nodes is to load a 
+  //vector(overlap_map) the export with summation to the f_vec(owned_map)
+  //after summing into. ie import is uniquely-owned to multiply-owned
+  //export is multiply-owned to uniquely-owned
+
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+
+  typedef Thyra::TpetraOperatorVectorExtraction<Scalar,int> ConverterT;
+
+  const Teuchos::RCP<const vector_type > x_vec =
+    ConverterT::getConstTpetraVector(inArgs.get_x());
+
+  Teuchos::RCP<vector_type > u = Teuchos::rcp(new vector_type(x_overlap_map_));
+  Teuchos::RCP<vector_type > uold = Teuchos::rcp(new vector_type(x_overlap_map_));
+  {
+    Teuchos::TimeMonitor ImportTimer(*ts_time_import);
+    u->doImport(*x_vec,*importer_,Tpetra::INSERT);
+    uold->doImport(*u_old_,*importer_,Tpetra::INSERT);
+  }
+
+  //cn meshc_1d_ is built once in the constructor
+  Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> meshc_1dra(meshc_1d_);
 
-	    for( int neq = 0; neq < numeqs; neq++ ){
-#ifdef KOKKOS_HAVE_CUDA
-	      //const double val = 0.;//BGPUarr[0].jac*BGPUarr[0].wt*(d_rf[0](&(BGPUarr[0]),i,dt,t_theta,time,neq));
-	      const double val = jacwt*((d_rf[neq])(*BGPU,i,dt,t_theta,time,neq));
-#else
-	      //const double val = BGPU->jac*BGPU->wt*(*residualfunc_)[0](BGPU,i,dt,1.,0.,0);
-	      //const double val = BGPU->jac*BGPU->wt*(tusastpetra::residual_heat_test_(BGPU,i,dt,1.,0.,0));//cn call directly
-	      const double val = jacwt*(h_rf[neq](*BGPU,i,dt,t_theta,time,neq));
-#endif
-	      //cn this works because we are filling an overlap map and exporting to a node map below...
-	      const int lid = lrow+neq;
-	      f_1d[lid] += val;
-	    }//neq
-	  }//i
-	}//gp
-#ifdef USE_TEAM
-			       }//if ne
-#else
-#endif
-      });//parallel_for
-		     //};//ne
+  const double time = time_; //cuda 8 lambdas dont capture private data
+  
+  if (nonnull(outArgs.get_f())){
 
-    }//c 
+    const RCP<vector_type> f_vec =
+      ConverterT::getTpetraVector(outArgs.get_f());
+
+    Teuchos::RCP<vector_type> f_overlap = Teuchos::rcp(new vector_type(x_overlap_map_));
+    f_vec->scale(0.);
+    f_overlap->scale(0.);
+    Teuchos::TimeMonitor ResFillTimer(*ts_time_resfill);  
 
+    switch(fill_functor_){
+    case tpetra::HEAT_FILL:
+      fill_residual(tpetra::heat_functor(), u, uold, f_overlap, meshc_1dra);
+      break;
+    case tpetra::FARZADI_FILL:
+      fill_residual(tpetra::farzadi_functor(), u, uold, f_overlap, meshc_1dra);
+      break;
+    default:
+      {
 #ifdef KOKKOS_HAVE_CUDA
-  cudaFree(d_rf);
-  free(h_rf);
+        fill_residual(tpetra::pointer_functor(d_rf_,NULL), u, uold, f_overlap, meshc_1dra);
+#else
+        fill_residual(tpetra::pointer_functor(h_rf_,NULL), u, uold, f_overlap, meshc_1dra);
 #endif
+      }
+    }//switch
 
     {
       Teuchos::TimeMonitor ImportTimer(*ts_time_import);  
@@ -662,6 +971,21 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
       f_vec->doExport(*f_overlap, *exporter_, Tpetra::REPLACE);//REPLACE ???
     }
   }//get_f
+
+  if (nonnull(outArgs.get_f()) && split_stage_){
+    //cn equations not advanced in this split stage are held at u_old_
+    const RCP<vector_type> f_vec =
+      ConverterT::getTpetraVector(outArgs.get_f());
+    ArrayRCP<scalar_type> fv = f_vec->get1dViewNonConst();
+    ArrayRCP<const scalar_type> xv = x_vec->getData();
+    ArrayRCP<const scalar_type> uoldv = u_old_->getData();
+    for( int k = 0; k < numeqs_; k++ ){
+      if( eqn_active_[k] ) continue;
+      for (int nn=0; nn < num_owned_nodes_; nn++) {
+	fv[numeqs_*nn+k] = xv[numeqs_*nn+k] - uoldv[numeqs_*nn+k];
+      }
+    }
+  }//get_f && split_stage_
       
   if( nonnull(outArgs.get_W_prec() )){
 
@@ -673,145 +997,22 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
     P->resumeFill();
     P->setAllToScalar((scalar_type)0.0); 
 
-    auto PV = P->getLocalMatrix();//this is a KokkosSparse::CrsMatrix<scalar_type,local_ordinal_type, node_type> PV = P->getLocalMatrix();
-
-
-    PREFUNC * h_pf;
-    h_pf = (PREFUNC*)malloc(numeqs_*sizeof(PREFUNC));
-
+    switch(fill_functor_){
+    case tpetra::HEAT_FILL:
+      fill_prec(tpetra::heat_functor(), u, meshc_1dra);
+      break;
+    case tpetra::FARZADI_FILL:
+      fill_prec(tpetra::farzadi_functor(), u, meshc_1dra);
+      break;
+    default:
+      {
 #ifdef KOKKOS_HAVE_CUDA
-    PREFUNC * d_pf;
-    cudaMalloc((double**)&d_pf,numeqs_*sizeof(PREFUNC));
-
-    if("heat" == paramList.get<std::string> (TusastestNameString)){
-      //cn this will need to be done for each equation
-      cudaMemcpyFromSymbol( &h_pf[0], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
-    }else if("heat2" == paramList.get<std::string> (TusastestNameString)){
-      cudaMemcpyFromSymbol( &h_pf[0], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
-      cudaMemcpyFromSymbol( &h_pf[1], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
-    }else if("farzadi" == paramList.get<std::string> (TusastestNameString)){
-      cudaMemcpyFromSymbol( &h_pf[0], tpetra::farzadi3d::prec_conc_farzadi_dp_, sizeof(PREFUNC));
-      cudaMemcpyFromSymbol( &h_pf[1], tpetra::farzadi3d::prec_phase_farzadi_dp_, sizeof(PREFUNC));
-
-    } else {
-      if( 0 == comm_->getRank() ){
-	std::cout<<std::endl<<std::endl<<"Test case: "<<paramList.get<std::string> (TusastestNameString)
-		 <<" precon function not found. (void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(...))" <<std::endl<<std::endl<<std::endl;
-      }
-      exit(0);
-    }
-
-    cudaMemcpy(d_pf,h_pf,numeqs_*sizeof(PREFUNC),cudaMemcpyHostToDevice);
-
+        fill_prec(tpetra::pointer_functor(NULL,d_pf_), u, meshc_1dra);
 #else
-    h_pf = &(*preconfunc_)[0];
+        fill_prec(tpetra::pointer_functor(NULL,h_pf_), u, meshc_1dra);
 #endif
-
-
-    for(int c = 0; c < num_color; c++){
-      //std::vector<int> elem_map = colors[c];
-      std::vector<int> elem_map = Elem_col->get_color(c);
-
-      const int num_elem = elem_map.size();
-
-
-      Kokkos::View<int*,Kokkos::DefaultExecutionSpace> elem_map_1d("elem_map_1d",num_elem);
-      //Kokkos::vector<int> elem_map_k(num_elem);
-      for(int i = 0; i<num_elem; i++) {
-	//elem_map_k[i] = elem_map[i];
-	elem_map_1d(i) = elem_map[i]; 
-	//std::cout<<comm_->getRank()<<" "<<c<<" "<<i<<" "<<elem_map_k[i]<<std::endl;
       }
-      //exit(0);	
-
-      Kokkos::parallel_for(num_elem,KOKKOS_LAMBDA(const size_t ne){
-
-
-	GPUBasis * BGPU[TUSAS_MAX_NUMEQS];
-	
-	GPUBasisLQuad Bq[TUSAS_MAX_NUMEQS];
-	GPUBasisLHex Bh[TUSAS_MAX_NUMEQS];
-	if(4 == n_nodes_per_elem)  {
-	  for( int neq = 0; neq < numeqs; neq++ )
-	    BGPU[neq] = &Bq[neq];
-	}else{
-	  for( int neq = 0; neq < numeqs; neq++ )
-	    BGPU[neq] = &Bh[neq];
-	}
-	
-	const int ngp = BGPU[0]->ngp;
-
-	//const int elem = elem_map_k[ne];
-	const int elem = elem_map_1d(ne);
-
-	double xx[BASIS_NODES_PER_ELEM];
-	double yy[BASIS_NODES_PER_ELEM];
-	double zz[BASIS_NODES_PER_ELEM];
-	double uu[TUSAS_MAX_NUMEQS_X_BASIS_NODES_PER_ELEM];
-
-	const int elemrow = elem*n_nodes_per_elem;
-	for(int k = 0; k < n_nodes_per_elem; k++){
-	  
-	  //const int nodeid = meshc[elemrow+k];
-	  const int nodeid = meshc_1d(elemrow+k);
-	  
-	  xx[k] = x_1dra(nodeid);
-	  yy[k] = y_1dra(nodeid);
-	  zz[k] = z_1dra(nodeid);
-
-	  for( int neq = 0; neq < numeqs; neq++ ){
-	    uu[n_nodes_per_elem*neq+k] = u_1dra(numeqs*nodeid+neq); 
-	  }//neq
-	}//k
-
-	for( int neq = 0; neq < numeqs; neq++ ){
-	  BGPU[neq]->computeElemData(&xx[0], &yy[0], &zz[0]);
-	}//neq
-
-	for(int gp=0; gp < ngp; gp++) {//gp
-	  for( int neq = 0; neq < numeqs; neq++ ){
-	    BGPU[neq]->getBasis(gp, &xx[0], &yy[0], &zz[0], &uu[neq*n_nodes_per_elem], NULL,NULL);
-	  }//neq
-	  const double jacwt = BGPU[0]->jac*BGPU[0]->wt;
-	  for (int i=0; i< n_nodes_per_elem; i++) {//i
-	    //const local_ordinal_type lrow = numeqs*meshc[elemrow+i];
-	    const local_ordinal_type lrow = numeqs*meshc_1d(elemrow+i);
-	    for(int j=0;j < n_nodes_per_elem; j++) {
-	      //local_ordinal_type lcol[1] = {numeqs*meshc[elemrow+j]};
-	      local_ordinal_type lcol[1] = {numeqs*meshc_1d(elemrow+j)};
-	      
-	      for( int neq = 0; neq < numeqs; neq++ ){
-#ifdef KOKKOS_HAVE_CUDA
-		scalar_type val[1] = {jacwt*d_pf[neq](*BGPU,i,j,dt,t_theta,neq)};
-#else
-		scalar_type val[1] = {jacwt*h_pf[neq](*BGPU,i,j,dt,t_theta,neq)};
-#endif
-		
-		//cn probably better to fill a view for val and lcol for each column
-		const local_ordinal_type row = lrow +neq; 
-		local_ordinal_type col[1] = {lcol[0] + neq};
-		
-		//cn this call seems to be what is crashing the cuda version
-		
-	      //P->sumIntoLocalValues(lrow,(local_ordinal_type)1,val,lcol,false);
-		PV.sumIntoValues (row, col,(local_ordinal_type)1,val);
-		
-	      }//neq
-		
-	    }//j
-	    
-	  }//i
-
-	}//gp
-
-      });//parallel_for
-
-    }//c
-
-#ifdef KOKKOS_HAVE_CUDA
-  cudaFree(d_pf);
-  free(h_pf);
-#endif
+    }//switch
 
     //cn we need to do a similar comm here...
     P->fillComplete();
@@ -1003,6 +1204,31 @@ void ModelEvaluatorTPETRA<Scalar>::evalModelImpl(
 //     exit(0);
   }//outArgs.get_W_prec() && dirichletfunc_
 
+  if( nonnull(outArgs.get_W_prec() ) && split_stage_ ){
+    //cn held equations get identity rows, as dirichlet rows above
+    Teuchos::TimeMonitor PrecFillTimer(*ts_time_precfill);
+    P_->resumeFill();
+    for( int k = 0; k < numeqs_; k++ ){
+      if( eqn_active_[k] ) continue;
+      for (int nn=0; nn < num_owned_nodes_; nn++) {
+	int ncol = 0;
+	const int * inds;
+	const Scalar * val;
+	const int row = numeqs_*nn +k;
+	P_->getLocalRowViewRaw( row, ncol, inds, val );
+	Scalar * vals = new Scalar[ncol];
+	for(int i = 0; i<ncol; i++){
+	  vals[i] = 0.0;
+	}
+	P_->replaceLocalValues(row, ncol, vals, inds );
+	vals[0] = 1.0;
+	P_->replaceLocalValues(row, 1 , vals, &row );
+	delete[] vals;
+      }//nn
+    }//k
+    P_->fillComplete();
+  }//outArgs.get_W_prec() && split_stage_
+
   if( nonnull(outArgs.get_W_prec() )){
 
     MueLu::ReuseTpetraPreconditioner( P_, *prec_  );
@@ -1194,39 +1420,53 @@ ModelEvaluatorTPETRA<scalar_type>::createOutArgsImpl() const
 template<class scalar_type>
 void ModelEvaluatorTPETRA<scalar_type>::advance()
 {
-  Teuchos::RCP< VectorBase< double > > guess = Thyra::createVector(u_old_,x_space_);
-  NOX::Thyra::Vector thyraguess(*guess);//by sending the dereferenced pointer, we instigate a copy rather than a view
-  solver_->reset(thyraguess);
+  bool implicit_solve = true;
+  if( split_ ){
+    advance_subcycle();
+    implicit_solve = false;
+    for( int k = 0; k < numeqs_; k++ ) if( eqn_active_[k] ) implicit_solve = true;
+  }
 
-  {
-    Teuchos::TimeMonitor NSolveTimer(*ts_time_nsolve);
+  if( "none" != explicit_method_ ){
+    advance_explicit();
+  }
+  else if( implicit_solve ){
+    Teuchos::RCP< VectorBase< double > > guess = Thyra::createVector(u_old_,x_space_);
+    NOX::Thyra::Vector thyraguess(*guess);//by sending the dereferenced pointer, we instigate a copy rather than a view
+    solver_->reset(thyraguess);
+
+    {
+      Teuchos::TimeMonitor NSolveTimer(*ts_time_nsolve);
 
-    NOX::StatusTest::StatusType solvStatus = solver_->solve();
-    if( !(NOX::StatusTest::Converged == solvStatus)) {
-      std::cout<<" NOX solver failed to converge. Status = "<<solvStatus<<std::endl<<std::endl;
-      if(200 == paramList.get<int> (TusasnoxmaxiterNameString)) exit(0);
+      NOX::StatusTest::StatusType solvStatus = solver_->solve();
+      if( !(NOX::StatusTest::Converged == solvStatus)) {
+        std::cout<<" NOX solver failed to converge. Status = "<<solvStatus<<std::endl<<std::endl;
+        if(200 == paramList.get<int> (TusasnoxmaxiterNameString)) exit(0);
+      }
     }
-  }
-  nnewt_ += solver_->getNumIterations();
+    nnewt_ += solver_->getNumIterations();
 
-  const Thyra::VectorBase<double> * sol = 
-    &(dynamic_cast<const NOX::Thyra::Vector&>(
-					      solver_->getSolutionGroup().getX()
-					      ).getThyraVector()
-      );
-  Thyra::ConstDetachedSpmdVectorView<double> x_vec(sol->col(0));
+    const Thyra::VectorBase<double> * sol = 
+      &(dynamic_cast<const NOX::Thyra::Vector&>(
+  					      solver_->getSolutionGroup().getX()
+  					      ).getThyraVector()
+        );
+    Thyra::ConstDetachedSpmdVectorView<double> x_vec(sol->col(0));
 
-  ArrayRCP<scalar_type> uv = u_old_->get1dViewNonConst();
-  const size_t localLength = num_owned_nodes_;
+    ArrayRCP<scalar_type> uv = u_old_->get1dViewNonConst();
+    const size_t localLength = num_owned_nodes_;
 
 
-  for (int nn=0; nn < localLength; nn++) {//cn figure out a better way here...
+    for (int nn=0; nn < localLength; nn++) {//cn figure out a better way here...
 
-    for( int k = 0; k < numeqs_; k++ ){
-      uv[numeqs_*nn+k]=x_vec[numeqs_*nn+k];
+      for( int k = 0; k < numeqs_; k++ ){
+        uv[numeqs_*nn+k]=x_vec[numeqs_*nn+k];
+      }
     }
   }
 
+  split_stage_ = false;
+
   time_ +=dt_;
 
   for(boost::ptr_vector<error_estimator>::iterator it = Error_est.begin();it != Error_est.end();++it){
@@ -1239,6 +1479,209 @@ void ModelEvaluatorTPETRA<scalar_type>::advance()
    
   postprocess();
 
+  analysis_step_++;
+  if( !Teuchos::is_null(insitu_) && 0 == analysis_step_%paramList.get<int> (TusasinsitufreqNameString) ){
+    Teuchos::RCP<const vector_type> temp = get_overlap_solution();
+    const ArrayRCP<const scalar_type> uv = temp->get1dView();
+    insitu_->process(analysis_step_, time_, uv.getRawPtr());
+  }
+  const int regionfreq = paramList.get<int> (TusasregionfreqNameString);
+  if( 0 < regionfreq && 0 == analysis_step_%regionfreq ) write_region();
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::advance_explicit()
+{
+  //cn strong stability preserving runge kutta, each stage is a forward euler step
+  //cn on u_old_; time_ is set to the stage time while the stage is evaluated
+  const double t0 = time_;
+  if( "euler" == explicit_method_ ){
+    explicit_stage();
+  }
+  else if( "rk2" == explicit_method_ ){
+    Teuchos::RCP<vector_type> un = Teuchos::rcp(new vector_type(*u_old_, Teuchos::Copy));
+    explicit_stage();
+    time_ = t0 + dt_;
+    explicit_stage();
+    u_old_->update(.5,*un,.5);
+  }
+  else if( "rk3" == explicit_method_ ){
+    Teuchos::RCP<vector_type> un = Teuchos::rcp(new vector_type(*u_old_, Teuchos::Copy));
+    explicit_stage();
+    time_ = t0 + dt_;
+    explicit_stage();
+    u_old_->update(.75,*un,.25);
+    time_ = t0 + .5*dt_;
+    explicit_stage();
+    u_old_->update(1./3.,*un,2./3.);
+  }
+  time_ = t0;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::advance_subcycle()
+{
+  //cn lie splitting: each sub-cycled equation in turn takes subcycle_[k] forward euler
+  //cn substeps of dt_/subcycle_[k] with the other equations held; advance() then solves
+  //cn the implicit equations with the sub-cycled ones held at their new values;
+  //cn explicit_stage() evaluates at theta = 1 and restores theta for the implicit solve
+  const double t0 = time_;
+  split_stage_ = true;
+  for( int k = 0; k < numeqs_; k++ ){
+    if( 0 == subcycle_[k] ) continue;
+    for( int kk = 0; kk < numeqs_; kk++ ) eqn_active_[kk] = (kk == k);
+    for( int s = 0; s < subcycle_[k]; s++ ){
+      time_ = t0 + s*dt_/subcycle_[k];
+      explicit_stage(1./subcycle_[k]);
+    }
+  }
+  for( int k = 0; k < numeqs_; k++ ) eqn_active_[k] = (0 == subcycle_[k]);
+  time_ = t0;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::explicit_stage(const double frac)
+{
+  //cn with x = u_old_ the time derivative term vanishes and f is the spatial operator at
+  //cn u_old_; theta = 1 puts all of it on the x side, since not every residual carries a
+  //cn (1-theta) term at u_old; dirichlet rows hold u - g and have unit mass
+  Teuchos::RCP<vector_type> f = Teuchos::rcp(new vector_type(x_owned_map_));
+
+  t_theta_ = 1.;
+  Thyra::ModelEvaluatorBase::InArgs<scalar_type> inArgs = this->createInArgs();
+  inArgs.set_x(Thyra::createVector(u_old_, x_space_));
+  Thyra::ModelEvaluatorBase::OutArgs<scalar_type> outArgs = this->createOutArgs();
+  outArgs.set_f(Thyra::createVector(f, f_space_));
+  this->evalModel(inArgs, outArgs);
+  t_theta_ = paramList.get<double> (TusasthetaNameString);
+
+  // u_old_ = u_old_ - frac*f/m
+  u_old_->elementWiseMultiply(-frac,*inv_lumped_mass_,*f,1.);
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::compute_geometry_cache()
+{
+  //cn the mesh does not move, so jac*wt, the Gauss point coordinates and the physical
+  //cn basis gradients are computed once here and read by the fills instead of
+  //cn gathering coordinates and recomputing the mapping every evaluation
+  const int blk = 0;
+  const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
+  const int num_elem = mesh_->get_num_elem_in_blk(blk);
+  const int num_dim = mesh_->get_num_dim();
+
+  GPUBasisLQuad Bq(ltp_quadrature_order_);
+  GPUBasisLHex Bh(ltp_quadrature_order_);
+  GPUBasis *B = (4 == n_nodes_per_elem) ? (GPUBasis *)&Bq : (GPUBasis *)&Bh;
+  const int ngp = B->ngp;
+
+  geo_jacwt_ = Kokkos::View<double**,Kokkos::DefaultExecutionSpace>("geo_jacwt",num_elem,ngp);
+  geo_xyz_ = Kokkos::View<double***,Kokkos::DefaultExecutionSpace>("geo_xyz",num_elem,ngp,num_dim);
+  geo_dphi_ = Kokkos::View<double****,Kokkos::DefaultExecutionSpace>("geo_dphi",num_elem,ngp,n_nodes_per_elem,num_dim);
+  auto h_jacwt = Kokkos::create_mirror_view(geo_jacwt_);
+  auto h_xyz = Kokkos::create_mirror_view(geo_xyz_);
+  auto h_dphi = Kokkos::create_mirror_view(geo_dphi_);
+
+  double xx[BASIS_NODES_PER_ELEM], yy[BASIS_NODES_PER_ELEM], zz[BASIS_NODES_PER_ELEM];
+  for(int ne = 0; ne < num_elem; ne++){
+    for(int k = 0; k < n_nodes_per_elem; k++){
+      const int nodeid = mesh_->get_node_id(blk, ne, k);
+      xx[k] = mesh_->get_x(nodeid);
+      yy[k] = mesh_->get_y(nodeid);
+      zz[k] = mesh_->get_z(nodeid);
+    }
+    B->computeElemData(xx, yy, zz);
+    for(int gp = 0; gp < ngp; gp++){
+      B->getBasis(gp, xx, yy, zz, NULL, NULL, NULL);
+      h_jacwt(ne,gp) = B->jac*B->wt;
+      h_xyz(ne,gp,0) = B->xx;
+      h_xyz(ne,gp,1) = B->yy;
+      if( 3 == num_dim ) h_xyz(ne,gp,2) = B->zz;
+      for(int i = 0; i < n_nodes_per_elem; i++){
+	h_dphi(ne,gp,i,0) = B->dphidx[i];
+	h_dphi(ne,gp,i,1) = B->dphidy[i];
+	if( 3 == num_dim ) h_dphi(ne,gp,i,2) = B->dphidz[i];
+      }
+    }
+  }
+  Kokkos::deep_copy(geo_jacwt_, h_jacwt);
+  Kokkos::deep_copy(geo_xyz_, h_xyz);
+  Kokkos::deep_copy(geo_dphi_, h_dphi);
+
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  if( 0 == comm_->getRank() )
+    std::cout<<"  Geometry cache: "<<ngp<<" Gauss points, "
+	     <<(double)num_elem*ngp*(1 + num_dim + n_nodes_per_elem*num_dim)*sizeof(double)/1048576.
+	     <<" MB on proc 0"<<std::endl;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::compute_lumped_mass()
+{
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+
+  Teuchos::RCP<vector_type> u = Teuchos::rcp(new vector_type(x_overlap_map_));
+  {
+    Teuchos::TimeMonitor ImportTimer(*ts_time_import);
+    u->doImport(*u_old_,*importer_,Tpetra::INSERT);
+  }
+  Kokkos::View<const int*, Kokkos::MemoryTraits<Kokkos::RandomAccess>> meshc_1dra(meshc_1d_);
+
+  Teuchos::RCP<vector_type> m_overlap = Teuchos::rcp(new vector_type(x_overlap_map_));
+  m_overlap->scale(0.);
+
+  switch(fill_functor_){
+  case tpetra::HEAT_FILL:
+    fill_lumped_mass(tpetra::heat_functor(), u, m_overlap, meshc_1dra);
+    break;
+  case tpetra::FARZADI_FILL:
+    fill_lumped_mass(tpetra::farzadi_functor(), u, m_overlap, meshc_1dra);
+    break;
+  default:
+    if( NULL == h_pf_ ){
+      if( 0 == comm_->getRank() ){
+	std::cout<<std::endl<<std::endl<<"Test case: "<<paramList.get<std::string> (TusastestNameString)
+		 <<" has no precon function; explicit integration needs it for the lumped mass." <<std::endl<<std::endl<<std::endl;
+      }
+      exit(0);
+    }
+#ifdef KOKKOS_HAVE_CUDA
+    fill_lumped_mass(tpetra::pointer_functor(NULL,d_pf_), u, m_overlap, meshc_1dra);
+#else
+    fill_lumped_mass(tpetra::pointer_functor(NULL,h_pf_), u, m_overlap, meshc_1dra);
+#endif
+  }//switch
+
+  inv_lumped_mass_ = Teuchos::rcp(new vector_type(x_owned_map_));
+  {
+    Teuchos::TimeMonitor ImportTimer(*ts_time_import);  
+    inv_lumped_mass_->doExport(*m_overlap, *exporter_, Tpetra::ADD);
+  }
+
+  if( NULL != dirichletfunc_ ){
+    {
+      Teuchos::TimeMonitor ImportTimer(*ts_time_import);
+      m_overlap->doImport(*inv_lumped_mass_,*importer_,Tpetra::INSERT);
+    }
+    {
+      ArrayRCP<scalar_type> mv = m_overlap->get1dViewNonConst();
+      std::map<int,DBCFUNC>::iterator it;
+      for( int k = 0; k < numeqs_; k++ ){
+	for(it = (*dirichletfunc_)[k].begin();it != (*dirichletfunc_)[k].end(); ++it){
+	  const int ns_id = it->first;
+	  const mesh_span node_set = mesh_->get_node_set(ns_id);
+	  for ( int j = 0; j < node_set.size(); j++ ){
+	    mv[numeqs_*node_set[j] + k] = 1.;
+	  }//j
+	}//it
+      }//k
+    }
+    {
+      Teuchos::TimeMonitor ImportTimer(*ts_time_import);  
+      inv_lumped_mass_->doExport(*m_overlap, *exporter_, Tpetra::REPLACE);
+    }
+  }
+  inv_lumped_mass_->reciprocal(*inv_lumped_mass_);
 }
 
 template<class scalar_type>
@@ -1247,57 +1690,140 @@ template<class scalar_type>
   auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
   if( 0 == comm_->getRank()) std::cout<<std::endl<<"inititialize started"<<std::endl<<std::endl;
   bool dorestart = paramList.get<bool> (TusasrestartNameString);
+  mesh_->set_output_options(paramList.get<bool> (TusasoutputfloatNameString),
+			    paramList.get<int> (TusasoutputcompressionNameString));
   if (!dorestart){ 
     init(u_old_); 
 #if 0 
     *u_old_old_ = *u_old_;
 #endif  
 
-    int mypid = comm_->getRank();
-    int numproc = comm_->getSize();
-    
-    if( 1 == numproc ){//cn for now
-      //if( 0 == mypid ){
-      const char *outfilename = "results.e";
-      ex_id_ = mesh_->create_exodus(outfilename);
-      
+    create_output();
+    for( int k = 0; k < numeqs_; k++ ){
+      mesh_->add_nodal_field((*varnames_)[k]);
     }
-    else{
-      //std::string decompPath="decomp/";
-      std::string decompPath=paramList.get<std::string> (TusasoutputpathNameString);
-      //std::string pfile = decompPath+std::to_string(mypid+1)+"/results.e."+std::to_string(numproc)+"."+std::to_string(mypid);
-      
-      std::string mypidstring;
-      if ( numproc > 9 && mypid < 10 ){
-	mypidstring = std::to_string(0)+std::to_string(mypid);
-      }
-      else{
-	mypidstring = std::to_string(mypid);
-      }
-      
-      std::string pfile = decompPath+"/results.e."+std::to_string(numproc)+"."+mypidstring;
-      ex_id_ = mesh_->create_exodus(pfile.c_str());
-    }  
+    set_output_digits();
+    
+    output_step_ = 1;
+    write_exodus();
+  }
+
+
+  else{
+    restart(u_old_);//,u_old_old_);
+//     if(1==comm_->MyPID())
+//       std::cout<<"Restart unavailable"<<std::endl<<std::endl;
+//     exit(0);
     for( int k = 0; k < numeqs_; k++ ){
       mesh_->add_nodal_field((*varnames_)[k]);
     }
+    set_output_digits();
+    //cn a redistributed restart starts new results files with the restart state
+    if( 1 == output_step_ ) write_exodus();
+  }
+
+  //cn lumped mass is computed once from the initial (or restart) state
+  if( "none" != explicit_method_ || split_ ) compute_lumped_mass();
+
+  std::vector<int> insitu_fields = Teuchos::getArrayFromStringParameter<int>(paramList, TusasinsituNameString).toVector();
+  if( 0 < insitu_fields.size() ){
+    //cn next to the results files, as for the checkpoints
+    std::string ifile = "insitu.csv";
+    if( 1 < comm_->getSize() ) ifile = paramList.get<std::string> (TusasoutputpathNameString)+"/"+ifile;
+    insitu_ = Teuchos::rcp(new insitu_analysis(Comm, mesh_, *varnames_, insitu_fields,
+					       paramList.get<int> (TusasinsitubinsNameString),
+					       paramList.get<double> (TusasinsituminNameString),
+					       paramList.get<double> (TusasinsitumaxNameString),
+					       ifile,
+					       dorestart));
+  }
+  analysis_step_ = this->start_step;
+
+  region_ex_id_ = -1;
+  region_series_ = 0;
+  if( 0 < paramList.get<int> (TusasregionfreqNameString) ){
+    const int nbox = Teuchos::getArrayFromStringParameter<double>(paramList, TusasregionboxNameString).size();
+    const int ns_id = paramList.get<int> (TusasregionnodesetNameString);
+    const int field = paramList.get<int> (TusasregionfieldNameString);
+    int num_node_sets = 0;
+    const int my_num_node_sets = mesh_->get_num_node_sets();
+    Teuchos::reduceAll<int,int>(*comm_, Teuchos::REDUCE_MAX, 1, &my_num_node_sets, &num_node_sets);
+    if( 0 != nbox && 4 != nbox && 6 != nbox ){
+      if( 0 == comm_->getRank()) std::cout<<"regionbox needs 4 or 6 values."<<std::endl;
+      exit(0);
+    }
+    if( -1 > ns_id || num_node_sets <= ns_id ){
+      if( 0 == comm_->getRank()) std::cout<<"regionnodeset "<<ns_id<<" does not exist; the mesh has "
+				       <<num_node_sets<<" node sets."<<std::endl;
+      exit(0);
+    }
+    if( 1 > paramList.get<int> (TusasregionstrideNameString) ){
+      if( 0 == comm_->getRank()) std::cout<<"regionstride has to be at least 1."<<std::endl;
+      exit(0);
+    }
+    if( numeqs_ <= field
+	|| ( 0 <= field && 2 != Teuchos::getArrayFromStringParameter<double>(paramList, TusasregionwindowNameString).size() ) ){
+      if( 0 == comm_->getRank()) std::cout<<"regionfield needs an existing equation and a regionwindow {lo,hi}."<<std::endl;
+      exit(0);
+    }
+    //cn a restart continues the series of the run it restarts instead of overwriting region.e
+    if( dorestart ){
+      if( 0 == comm_->getRank() )
+	while( std::ifstream(region_file(region_series_+1, 0, comm_->getSize()).c_str()).good() ) region_series_++;
+      Teuchos::broadcast<int, int>(*comm_, 0, &region_series_);
+    }
+    write_region();
+  }
+   
+  if( 0 == comm_->getRank()) std::cout<<std::endl<<"initialize finished"<<std::endl<<std::endl;
+}
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::create_output(const bool append)
+{
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int mypid = comm_->getRank();
+  int numproc = comm_->getSize();
+  
+  if( 1 == numproc ){//cn for now
+    //if( 0 == mypid ){
+    const char *outfilename = "results.e";
+    ex_id_ = append ? mesh_->open_exodus(outfilename) : mesh_->create_exodus(outfilename);
+    
+  }
+  else if( paramList.get<bool> (TusasglobaloutputNameString) ){
+    //cn one global file, written by proc 0; no join afterwards
+    ex_id_ = append ? mesh_->open_exodus_global("results.e") : mesh_->create_exodus_global("results.e");
+  }
+  else{
+    //std::string decompPath="decomp/";
+    std::string decompPath=paramList.get<std::string> (TusasoutputpathNameString);
+    //std::string pfile = decompPath+std::to_string(mypid+1)+"/results.e."+std::to_string(numproc)+"."+std::to_string(mypid);
     
-    output_step_ = 1;
-    write_exodus();
+    std::string pfile = decompPath+"/results.e."+std::to_string(numproc)+"."+proc_string(mypid, numproc);
+    ex_id_ = append ? mesh_->open_exodus(pfile.c_str()) : mesh_->create_exodus(pfile.c_str());
   }
+}
 
+template<class scalar_type>
+std::string ModelEvaluatorTPETRA<scalar_type>::proc_string(const int pid, const int numproc) const
+{
+  const std::string pidstring = std::to_string(pid);
+  return std::string(std::to_string(numproc).size() - pidstring.size(), '0') + pidstring;
+}
 
-  else{
-    restart(u_old_);//,u_old_old_);
-//     if(1==comm_->MyPID())
-//       std::cout<<"Restart unavailable"<<std::endl<<std::endl;
-//     exit(0);
-    for( int k = 0; k < numeqs_; k++ ){
-      mesh_->add_nodal_field((*varnames_)[k]);
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::set_output_digits()
+{
+  std::vector<int> digits = (Teuchos::getArrayFromStringParameter<int>(paramList,
+								   TusasoutputdigitsNameString)).toVector();
+  if( 0 == digits.size() ) return;
+  if( numeqs_ != digits.size() ){
+    if( 0 == Teuchos::DefaultComm<int>::getComm()->getRank() ){
+      std::cout<<std::endl<<std::endl<<"outputdigits needs one entry per equation." <<std::endl<<std::endl<<std::endl;
     }
+    exit(0);
   }
-   
-  if( 0 == comm_->getRank()) std::cout<<std::endl<<"initialize finished"<<std::endl<<std::endl;
+  for( int k = 0; k < numeqs_; k++ ) mesh_->set_nodal_field_digits((*varnames_)[k], digits[k]);
 }
 template<class scalar_type>
 void ModelEvaluatorTPETRA<scalar_type>::init(Teuchos::RCP<vector_type> u)
@@ -1334,6 +1860,10 @@ template<class scalar_type>
 void ModelEvaluatorTPETRA<scalar_type>::set_test_case()
 {
   paramfunc_ = NULL;
+  fill_functor_ = tpetra::POINTER_FILL;
+  coupled_mass_ = false;
+  residualfunc_ = NULL;
+  preconfunc_ = NULL;
 
   if("heat" == paramList.get<std::string> (TusastestNameString)){
     // numeqs_ number of variables(equations) 
@@ -1365,6 +1895,8 @@ void ModelEvaluatorTPETRA<scalar_type>::set_test_case()
 
     paramfunc_ = tpetra::param_;
 
+    fill_functor_ = tpetra::HEAT_FILL;
+
     post_proc.push_back(new post_process(Comm,mesh_,(int)0));
     post_proc[0].postprocfunc_ = &tpetra::postproc_;
 
@@ -1405,6 +1937,8 @@ void ModelEvaluatorTPETRA<scalar_type>::set_test_case()
     (*dirichletfunc_)[1][2] = &dbc_zero_;						 
     (*dirichletfunc_)[1][3] = &dbc_zero_;
 
+    fill_functor_ = tpetra::HEAT_FILL;
+
 //     neumannfunc_ = NULL;
 
   }else if("cummins" == paramList.get<std::string> (TusastestNameString)){
@@ -1461,6 +1995,9 @@ void ModelEvaluatorTPETRA<scalar_type>::set_test_case()
     dirichletfunc_ = NULL;
 
     paramfunc_ = tpetra::farzadi3d::param_;
+
+    fill_functor_ = tpetra::FARZADI_FILL;
+    coupled_mass_ = true;//cn phi_t appears in the u equation
     //paramfunc_ = farzadi::param_;
 
   } else {
@@ -1472,6 +2009,48 @@ void ModelEvaluatorTPETRA<scalar_type>::set_test_case()
     exit(0);
   }
 
+  //cn resolve the pointer tables for the fallback fill once here; under cuda they are
+  //cn copied from the device symbols and stay resident until finalize()
+  h_rf_ = NULL;
+  h_pf_ = NULL;
+#ifdef KOKKOS_HAVE_CUDA
+  d_rf_ = NULL;
+  d_pf_ = NULL;
+  h_rf_ = (RESFUNC*)malloc(numeqs_*sizeof(RESFUNC));
+  h_pf_ = (PREFUNC*)malloc(numeqs_*sizeof(PREFUNC));
+
+  if("heat" == paramList.get<std::string> (TusastestNameString)){
+    cudaMemcpyFromSymbol( &h_rf_[0], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
+    cudaMemcpyFromSymbol( &h_pf_[0], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
+  }else if("heat2" == paramList.get<std::string> (TusastestNameString)){
+    cudaMemcpyFromSymbol( &h_rf_[0], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
+    cudaMemcpyFromSymbol( &h_rf_[1], tpetra::residual_heat_test_dp_, sizeof(RESFUNC));
+    cudaMemcpyFromSymbol( &h_pf_[0], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
+    cudaMemcpyFromSymbol( &h_pf_[1], tpetra::prec_heat_test_dp_, sizeof(PREFUNC));
+  }else if("farzadi" == paramList.get<std::string> (TusastestNameString)){
+    cudaMemcpyFromSymbol( &h_rf_[0], tpetra::farzadi3d::residual_conc_farzadi_dp_, sizeof(RESFUNC));
+    cudaMemcpyFromSymbol( &h_rf_[1], tpetra::farzadi3d::residual_phase_farzadi_dp_, sizeof(RESFUNC));
+    cudaMemcpyFromSymbol( &h_pf_[0], tpetra::farzadi3d::prec_conc_farzadi_dp_, sizeof(PREFUNC));
+    cudaMemcpyFromSymbol( &h_pf_[1], tpetra::farzadi3d::prec_phase_farzadi_dp_, sizeof(PREFUNC));
+  } else {
+    auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+    if( 0 == comm_->getRank() ){
+      std::cout<<std::endl<<std::endl<<"Test case: "<<paramList.get<std::string> (TusastestNameString)
+	       <<" device residual function not found. (void ModelEvaluatorTPETRA<scalar_type>::set_test_case())" <<std::endl<<std::endl<<std::endl;
+    }
+    exit(0);
+  }
+
+  cudaMalloc((double**)&d_rf_,numeqs_*sizeof(RESFUNC));
+  cudaMalloc((double**)&d_pf_,numeqs_*sizeof(PREFUNC));
+  cudaMemcpy(d_rf_,h_rf_,numeqs_*sizeof(RESFUNC),cudaMemcpyHostToDevice);
+  cudaMemcpy(d_pf_,h_pf_,numeqs_*sizeof(PREFUNC),cudaMemcpyHostToDevice);
+#else
+  //it seems that evaluating the function via pointer ie h_rf[0] is way faster that evaluation via (*residualfunc_)[0]
+  if( NULL != residualfunc_) h_rf_ = &(*residualfunc_)[0];
+  if( NULL != preconfunc_) h_pf_ = &(*preconfunc_)[0];
+#endif
+
   if(numeqs_ > TUSAS_MAX_NUMEQS){
     auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
     if( 0 == comm_->getRank() ){
@@ -1497,54 +2076,82 @@ template<class scalar_type>
 void ModelEvaluatorTPETRA<scalar_type>::write_exodus()
 //void ModelEvaluatorNEMESIS<scalar_type>::write_exodus(const int output_step)
 {
+  //cn the fields staged in mesh_ are the second buffer, the previous write has to be done with them
+  wait_write_exodus();
+
+  //cn in situ rows reach the disk at least as often as the fields
+  if( !Teuchos::is_null(insitu_) ) insitu_->flush();
+
   update_mesh_data();
 
   //not sre what the bug is here...
   Teuchos::TimeMonitor IOWriteTimer(*ts_time_iowrite);
-  mesh_->write_exodus(ex_id_,output_step_,time_);
+
+  //cn the gather is collective, so it stays on this thread; only proc 0 writes the global file
+  const bool global = 1 < Teuchos::DefaultComm<int>::getComm()->getSize()
+    && paramList.get<bool> (TusasglobaloutputNameString);
+  if( global ) mesh_->gather_exodus_global();
+
+  if( paramList.get<bool> (TusasasyncoutputNameString) ){
+    //cn sets still on disk would be read by ex_open on the writer thread, e.g. after a restart
+    mesh_->load_sets();
+    //cn the error exits call exit(0), which does not run the destructor
+    if( NULL == io_model_ ){
+      io_model_ = this;
+      std::atexit(wait_write_exodus_atexit);
+    }
+    const int step = output_step_;
+    const double time = time_;
+    io_thread_ = std::thread([this, global, step, time](){
+	if( global ) mesh_->write_exodus_global(ex_id_, step, time);
+	else mesh_->write_exodus(ex_id_, step, time);
+      });
+  }
+  else if( global ){
+    mesh_->write_exodus_global(ex_id_,output_step_,time_);
+  }
+  else{
+    mesh_->write_exodus(ex_id_,output_step_,time_);
+  }
   output_step_++;
 }
 
 template<class scalar_type>
-int ModelEvaluatorTPETRA<scalar_type>:: update_mesh_data()
+void ModelEvaluatorTPETRA<scalar_type>::wait_write_exodus()
 {
-  //std::cout<<"update_mesh_data()"<<std::endl;
+  if( !io_thread_.joinable() ) return;
 
-  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
-  //std::vector<int> node_num_map(mesh_->get_node_num_map());
+  Teuchos::TimeMonitor IOWriteTimer(*ts_time_iowrite);
+  io_thread_.join();
+}
 
-  //cn 8-28-18 we need an overlap map with mpi, since shared nodes live
-  // on the decomposed mesh----fix this later
-  Teuchos::RCP<vector_type> temp;
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::wait_write_exodus_atexit()
+{
+  //cn an exit on the writer thread itself cannot join it
+  if( NULL == io_model_ || std::this_thread::get_id() == io_model_->io_thread_.get_id() ) return;
+  if( io_model_->io_thread_.joinable() ) io_model_->io_thread_.join();
+}
 
-  if( 1 == comm_->getSize() ){
-    temp = Teuchos::rcp(new vector_type(*u_old_));
-  }
-  else{
-    temp = Teuchos::rcp(new vector_type(x_overlap_map_));//cn might be better to have u_old_ live on overlap map
-    temp->doImport(*u_old_, *importer_, Tpetra::INSERT);
-  }
+template<class scalar_type>
+int ModelEvaluatorTPETRA<scalar_type>:: update_mesh_data(const bool scalar_data)
+{
+  //std::cout<<"update_mesh_data()"<<std::endl;
 
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  //std::vector<int> node_num_map(mesh_->get_node_num_map());
 
   //cn 8-28-18 we need an overlap map with mpi, since shared nodes live
   // on the decomposed mesh----fix this later
-  int num_nodes = num_overlap_nodes_;
-  std::vector<std::vector<double>> output(numeqs_, std::vector<double>(num_nodes));
+  Teuchos::RCP<const vector_type> temp = get_overlap_solution();
 
-  const ArrayRCP<scalar_type> uv = temp->get1dViewNonConst();
-  //const size_t localLength = num_owned_nodes_;
+  //cn the host view is interleaved by equation, so each variable is
+  //cn handed to the mesh with stride numeqs_ and no intermediate copy
+  const ArrayRCP<const scalar_type> uv = temp->get1dView();
 
-  for( int k = 0; k < numeqs_; k++ ){
-    //#pragma omp parallel for
-    for (int nn=0; nn < num_nodes; nn++) {
-      //output[k][nn]=(*temp)[numeqs_*nn+k];
-      output[k][nn]=uv[numeqs_*nn+k];
-      //std::cout<<uv[numeqs_*nn+k]<<std::endl;
-    }
-  }
   int err = 0;
   for( int k = 0; k < numeqs_; k++ ){
-    mesh_->update_nodal_data((*varnames_)[k], &output[k][0]);
+    mesh_->update_nodal_data((*varnames_)[k], uv.getRawPtr() + k, numeqs_);
   }
 
   boost::ptr_vector<error_estimator>::iterator it;
@@ -1555,13 +2162,125 @@ int ModelEvaluatorTPETRA<scalar_type>:: update_mesh_data()
   boost::ptr_vector<post_process>::iterator itp;
   for(itp = post_proc.begin();itp != post_proc.end();++itp){
     itp->update_mesh_data();
-    itp->update_scalar_data(time_);
+    if( scalar_data ) itp->update_scalar_data(time_);
   }
 
   Elem_col->update_mesh_data();
 
   return err;
 }
+template<class scalar_type>
+Teuchos::RCP<const typename ModelEvaluatorTPETRA<scalar_type>::vector_type> ModelEvaluatorTPETRA<scalar_type>::get_overlap_solution()
+{
+  //cn in serial u_old_ already is the overlap vector; otherwise import
+  //cn into a buffer that persists across calls
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  if( 1 == comm_->getSize() ) return u_old_;
+
+  if( Teuchos::is_null(output_overlap_) )
+    output_overlap_ = Teuchos::rcp(new vector_type(x_overlap_map_));//cn might be better to have u_old_ live on overlap map
+  output_overlap_->doImport(*u_old_, *importer_, Tpetra::INSERT);
+  return output_overlap_;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::write_region()
+{
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int mypid = comm_->getRank();
+  int numproc = comm_->getSize();
+
+  //cn the fields staged in mesh_ may still be in use by the background writer
+  wait_write_exodus();
+
+  //cn the post process scalars go out with the full output only
+  update_mesh_data(false);
+
+  Teuchos::TimeMonitor IOWriteTimer(*ts_time_iowrite);
+
+  const std::vector<double> box = Teuchos::getArrayFromStringParameter<double>(paramList, TusasregionboxNameString).toVector();
+  const std::vector<double> window = Teuchos::getArrayFromStringParameter<double>(paramList, TusasregionwindowNameString).toVector();
+  const int ns_id = paramList.get<int> (TusasregionnodesetNameString);
+  const int stride = paramList.get<int> (TusasregionstrideNameString);
+  const int field = paramList.get<int> (TusasregionfieldNameString);
+
+  //cn an element is kept when it passes every filter that is set: a node in the box, a node in
+  //cn the node set, a global id divisible by the stride and nodal values of field overlapping the window
+
+  const int num_nodes = mesh_->get_num_nodes();
+  std::vector<char> in_box(num_nodes, 1), in_set(num_nodes, 1);
+  if( !box.empty() ){
+    for(int j = 0; j < num_nodes; j++){
+      bool in = box[0] <= mesh_->get_x(j) && mesh_->get_x(j) <= box[1]
+	&& box[2] <= mesh_->get_y(j) && mesh_->get_y(j) <= box[3];
+      if( 6 == box.size() ) in = in && box[4] <= mesh_->get_z(j) && mesh_->get_z(j) <= box[5];
+      in_box[j] = in;
+    }
+  }
+  if( 0 <= ns_id ){
+    in_set.assign(num_nodes, 0);
+    const mesh_span ns = mesh_->get_node_set(ns_id);
+    for(int i = 0; i < ns.size(); i++) in_set[ns[i]] = 1;
+  }
+
+  Teuchos::RCP<const vector_type> temp = get_overlap_solution();
+  const ArrayRCP<const scalar_type> uv = temp->get1dView();
+
+  std::vector<int> elems;
+  for(int blk = 0, ne = 0; blk < mesh_->get_num_elem_blks(); blk++){
+    const int n_nodes_per_elem = mesh_->get_num_nodes_per_elem_in_blk(blk);
+    for(int e = 0; e < mesh_->get_num_elem_in_blk(blk); e++, ne++){
+      if( 0 != mesh_->get_global_elem_id(ne)%stride ) continue;
+      bool hit_box = false, hit_set = false;
+      double umin = std::numeric_limits<double>::max(), umax = -std::numeric_limits<double>::max();
+      for(int k = 0; k < n_nodes_per_elem; k++){
+	const int nodeid = mesh_->get_node_id(blk, e, k);
+	hit_box = hit_box || in_box[nodeid];
+	hit_set = hit_set || in_set[nodeid];
+	if( 0 <= field ){
+	  umin = std::min(umin, (double)uv[numeqs_*nodeid + field]);
+	  umax = std::max(umax, (double)uv[numeqs_*nodeid + field]);
+	}
+      }
+      if( !hit_box || !hit_set ) continue;
+      if( 0 <= field && (umax < window[0] || window[1] < umin) ) continue;
+      elems.push_back(ne);
+    }
+  }
+
+  //cn an exodus mesh is fixed, so a new side file is started whenever the selection changes on
+  //cn any proc, as with a threshold window following the interface: region.e, region.e-s.0002, ...
+  int changed = ( 0 > region_ex_id_ || elems != region_elems_ ) ? 1 : 0;
+  int gchanged = 0;
+  Teuchos::reduceAll<int,int>(*comm_, Teuchos::REDUCE_MAX, 1, &changed, &gchanged);
+
+  if( 0 < gchanged ){
+    if( 0 <= region_ex_id_ ) mesh_->close_exodus(region_ex_id_);
+    region_series_++;
+
+    const std::string rfile = region_file(region_series_, mypid, numproc);
+    region_ex_id_ = mesh_->create_exodus_subset(rfile.c_str(), elems);
+    region_elems_.swap(elems);
+    region_step_ = 1;
+  }
+
+  mesh_->write_exodus_subset(region_ex_id_, region_step_, time_);
+  region_step_++;
+}
+
+template<class scalar_type>
+std::string ModelEvaluatorTPETRA<scalar_type>::region_file(const int series, const int pid, const int numproc) const
+{
+  std::string rfile = "region.e";
+  if( 1 < series ){
+    const std::string sstring = std::to_string(series);
+    rfile += "-s." + std::string(4 - std::min(4, (int)sstring.size()), '0') + sstring;
+  }
+  if( 1 < numproc )
+    rfile = paramList.get<std::string> (TusasoutputpathNameString)+"/"+rfile+"."+std::to_string(numproc)+"."+proc_string(pid, numproc);
+  return rfile;
+}
+
 template<class scalar_type>
 void ModelEvaluatorTPETRA<scalar_type>::finalize()
 {
@@ -1572,11 +2291,14 @@ void ModelEvaluatorTPETRA<scalar_type>::finalize()
   bool dorestart = paramList.get<bool> (TusasrestartNameString);
 
   write_exodus();
+  wait_write_exodus();
+  if( !Teuchos::is_null(insitu_) ) insitu_->flush(true);
+  if( 0 <= region_ex_id_ ) mesh_->close_exodus(region_ex_id_);
 
   //std::cout<<(solver_->getList()).sublist("Direction").sublist("Newton").sublist("Linear Solver")<<std::endl;
   int ngmres = 0;
 
-  if ( (solver_->getList()).sublist("Direction").sublist("Newton").sublist("Linear Solver")
+  if ( !solver_.is_null() && (solver_->getList()).sublist("Direction").sublist("Newton").sublist("Linear Solver")
        .sublist("Output").getEntryPtr("Cumulative Iteration Count") != NULL)
     ngmres = ((solver_->getList()).sublist("Direction").sublist("Newton").sublist("Linear Solver")
 	      .sublist("Output").getEntry("Cumulative Iteration Count")).getValue(&ngmres);
@@ -1617,6 +2339,12 @@ void ModelEvaluatorTPETRA<scalar_type>::finalize()
   if(!u_old_.is_null()) u_old_=Teuchos::null;
   if(!dudt_.is_null()) dudt_=Teuchos::null;
 
+#endif
+#ifdef KOKKOS_HAVE_CUDA
+  cudaFree(d_rf_);
+  cudaFree(d_pf_);
+  free(h_rf_);
+  free(h_pf_);
 #endif
   delete residualfunc_;
   delete preconfunc_;
@@ -1643,6 +2371,23 @@ template<class scalar_type>
   int numproc = comm_->getSize();
   if( 0 == mypid )
     std::cout<<std::endl<<"Entering restart: PID "<<mypid<<" NumProcs "<<numproc<<std::endl<<std::endl;
+
+  if( paramList.get<bool> (TusasrestartcheckpointNameString) ){
+    //cn checkpoints are always per proc files
+    const int restart_procs = paramList.get<int> (TusasrestartnumprocNameString);
+    read_checkpoint(u, ( 0 == restart_procs ? numproc : restart_procs ));
+    return;
+  }
+
+  //cn only the files of this decomposition can be reopened in place; anything else
+  //cn is read by global node id and redistributed
+  const bool globaloutput = paramList.get<bool> (TusasglobaloutputNameString);
+  int restart_procs = paramList.get<int> (TusasrestartnumprocNameString);
+  if( 0 == restart_procs ) restart_procs = ( globaloutput ? 1 : numproc );
+  if( restart_procs != numproc || ( 1 < numproc && globaloutput ) ){
+    restart_redistribute(u, restart_procs);
+    return;
+  }
   
   if( 1 == numproc ){//cn for now
     //if( 0 == mypid ){
@@ -1655,47 +2400,8 @@ template<class scalar_type>
   else{
     std::string decompPath="decomp/";
     //std::string pfile = decompPath+std::to_string(mypid+1)+"/results.e."+std::to_string(numproc)+"."+std::to_string(mypid);
-    
-    std::string mypidstring;
 
-    if( numproc < 10 ){
-      mypidstring = std::to_string(mypid);
-    }
-    if( numproc > 9 && numproc < 100 ){
-      if ( mypid < 10 ){
-	mypidstring = std::to_string(0)+std::to_string(mypid);
-      }
-      else{
-	mypidstring = std::to_string(mypid);
-      }
-    }
-    if( numproc > 99 && numproc < 1000 ){
-      if ( mypid < 10 ){
-	mypidstring = std::to_string(0)+std::to_string(0)+std::to_string(mypid);
-      }
-      else if ( mypid > 9 && mypid < 100 ){
-	mypidstring = std::to_string(0)+std::to_string(mypid);
-      }
-      else{
-	mypidstring = std::to_string(mypid);
-      }
-      if( numproc > 999 && numproc < 10000 ){
-	if ( mypid < 10 ){
-	  mypidstring = std::to_string(0)+std::to_string(0)+std::to_string(0)+std::to_string(mypid);
-	}
-	else if ( mypid > 9 && mypid < 100 ){
-	  mypidstring = std::to_string(0)+std::to_string(0)+std::to_string(mypid);
-	}
-	else if ( mypid > 99 && mypid < 1000 ){
-	  mypidstring = std::to_string(0)+std::to_string(mypid);
-	}
-	else{
-	  mypidstring = std::to_string(mypid);
-	}
-      }
-    }
-     
-    std::string pfile = decompPath+"results.e."+std::to_string(numproc)+"."+mypidstring;
+    std::string pfile = decompPath+"results.e."+std::to_string(numproc)+"."+proc_string(mypid, numproc);
     ex_id_ = mesh_->open_exodus(pfile.c_str());
     
     std::cout<<"  Opening file for restart; ex_id_ = "<<ex_id_<<" filename = "<<pfile<<std::endl;
@@ -1788,6 +2494,308 @@ template<class scalar_type>
   //exit(0);
 }
 
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::restart_redistribute(Teuchos::RCP<vector_type> u, const int restart_procs)
+{
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int mypid = comm_->getRank();
+  int numproc = comm_->getSize();
+  if( 0 == mypid )
+    std::cout<<"  Redistributing restart from "<<restart_procs<<" procs to "<<numproc<<" procs"<<std::endl;
+
+  //cn with at least as many files as procs each proc reads whole files; otherwise
+  //cn the procs that share a file each read a range of its nodes
+
+  std::unordered_map<int, int> read_lid;
+  std::vector<int> read_gid;
+  std::vector<double> read_u;
+  int step = -99;
+  double time = -99.99;
+  int read_error = 0;
+
+  for( int f = 0; f < restart_procs; f++ ){
+    int part = 0;
+    int num_parts = 1;
+    if( restart_procs >= numproc ){
+      if( mypid != f%numproc ) continue;
+    }
+    else{
+      if( f != mypid%restart_procs ) continue;
+      part = mypid/restart_procs;
+      num_parts = (numproc - f + restart_procs - 1)/restart_procs;
+    }
+
+    std::string pfile = "results.e";
+    if( 1 < restart_procs )
+      pfile = paramList.get<std::string> (TusasoutputpathNameString)+"/results.e."+std::to_string(restart_procs)+"."
+	+proc_string(f, restart_procs);
+    if( 0 == mypid )
+      std::cout<<"  Reading restart part "<<part<<" of "<<num_parts<<"; filename = "<<pfile<<std::endl;
+
+    std::vector<int> gids;
+    std::vector<std::vector<double> > data;
+    if( 0 > mesh_->read_nodal_data_exodus(pfile.c_str(), *varnames_, part, num_parts, step, time, gids, data) ) {
+      std::cout<<"Error reading restart file "<<pfile<<std::endl;
+      read_error = 1;
+      continue;
+    }
+
+    //cn border nodes are in more than one file
+    for( int i = 0; i < gids.size(); i++ ){
+      if( !read_lid.insert(std::make_pair(gids[i], (int)read_gid.size())).second ) continue;
+      read_gid.push_back(gids[i]);
+      for( int k = 0; k < numeqs_; k++ ) read_u.push_back(data[k][i]);
+    }
+  }
+
+  //cn every proc has to leave together when any file could not be read
+  int gread_error = 0;
+  Teuchos::reduceAll<int, int>(*comm_, Teuchos::REDUCE_MAX, 1, &read_error, &gread_error);
+  if( 0 < gread_error ) exit(0);
+
+  //cn proc 0 always reads the first file
+  Teuchos::broadcast<int, int>(*comm_, 0, &step);
+  Teuchos::broadcast<int, double>(*comm_, 0, &time);
+  if( 0 == mypid )
+    std::cout<<"  Reading restart last step = "<<step<<" time = "<<time<<std::endl;
+
+  const double dt = paramList.get<double> (TusasdtNameString);
+  const int numSteps = paramList.get<int> (TusasntNameString);
+
+  if( step > numSteps || time >numSteps*dt ){
+    if( 0 == mypid ){
+      std::cout<<"  Error reading restart last time = "<<time<<std::endl;
+      std::cout<<"    is greater than    "<<numSteps*dt<<std::endl<<std::endl<<std::endl;
+    }
+    exit(0);
+  }
+
+  std::vector<int> my_global_nodes(numeqs_*read_gid.size());
+  for(int i = 0; i < read_gid.size(); i++){    
+    for( int k = 0; k < numeqs_; k++ ){
+      my_global_nodes[numeqs_*i+k] = numeqs_*read_gid[i]+k;
+    }
+  }
+
+  const global_size_t numGlobalEntries = Teuchos::OrdinalTraits<Tpetra::global_size_t>::invalid();
+  const global_ordinal_type indexBase = 0;
+
+  Teuchos::ArrayView<int> AV(my_global_nodes);
+
+  Teuchos::RCP<const map_type> read_map = Teuchos::rcp(new map_type(numGlobalEntries,
+								    AV,
+								    indexBase,
+								    comm_
+								    ));
+  vector_type u_read(read_map);
+  {
+    const ArrayRCP<scalar_type> uv = u_read.get1dViewNonConst();
+    for( int i = 0; i < read_u.size(); i++ ) uv[i] = read_u[i];
+  }
+
+  //cn the read layout overlaps on border nodes, so the values are sent to their
+  //cn owners the same way u_temp is in restart
+  export_type exporter(read_map, x_owned_map_);
+  u->doExport(u_read, exporter, Tpetra::INSERT);
+
+  this->start_time = time;
+  int ntstep = (int)(time/dt_);
+  this->start_step = ntstep;
+  time_=time;
+
+  //cn the global results.e is appended to when it is also the output; otherwise this
+  //cn decomposition gets new results files, which initialize starts with the restart state
+  if( 1 == restart_procs && 1 < numproc && paramList.get<bool> (TusasglobaloutputNameString) ){
+    ex_id_ = mesh_->open_exodus_global("results.e");
+    output_step_ = step+1;
+  }
+  else{
+    create_output();
+    output_step_ = 1;
+  }
+
+  if( 0 == mypid ){
+    std::cout<<"Restarting at time = "<<time<<" and step = "<<step<<std::endl<<std::endl;
+    std::cout<<"Exiting restart"<<std::endl<<std::endl;
+  }
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::checkpoint(const int step)
+{
+  const int freq = paramList.get<int> (TusascheckpointfreqNameString);
+  const double walltime = paramList.get<double> (TusascheckpointwalltimeNameString);
+  if( 0 >= freq && 0. >= walltime ) return;
+
+  //cn proc 0's clock decides, so every proc writes the same step
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int due = ( 0 < freq && 0 == step%freq ) ? 1 : 0;
+  if( 0. < walltime ){
+    if( 0 == comm_->getRank() && walltime <= Teuchos::Time::wallTime() - checkpoint_time_ ) due = 1;
+    Teuchos::broadcast<int, int>(*comm_, 0, &due);
+  }
+  if( 0 == due ) return;
+
+  write_checkpoint(step);
+  checkpoint_time_ = Teuchos::Time::wallTime();
+}
+
+template<class scalar_type>
+std::string ModelEvaluatorTPETRA<scalar_type>::checkpoint_file(const int pid, const int numproc) const
+{
+  //cn same place as the results files create_output writes for numproc procs
+  const std::string cfile = "checkpoint."+std::to_string(numproc)+"."+proc_string(pid, numproc);
+  if( 1 == numproc ) return cfile;
+  return paramList.get<std::string> (TusasoutputpathNameString)+"/"+cfile;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::write_checkpoint(const int step)
+{
+  //cn one raw binary file per proc: a header, then the owned global ids and values of u_old_;
+  //cn it is written to a temporary name and renamed, so a crash leaves the last good one
+
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int mypid = comm_->getRank();
+  int numproc = comm_->getSize();
+
+  const std::string cfile = checkpoint_file(mypid, numproc);
+  const std::string tfile = cfile+".tmp";
+
+  Teuchos::ArrayView<const global_ordinal_type> gids = x_owned_map_->getNodeElementList();
+  const ArrayRCP<const scalar_type> uv = u_old_->get1dView();
+
+  const char magic[8] = {'T','U','S','A','S','C','K','1'};
+  int header[6] = {numproc, mypid, numeqs_, (int)gids.size(), step, output_step_};
+  double theader[2] = {time_, dt_};
+
+  std::ofstream outfile(tfile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  outfile.write(magic, sizeof(magic));
+  outfile.write((const char*)header, sizeof(header));
+  outfile.write((const char*)theader, sizeof(theader));
+  outfile.write((const char*)gids.getRawPtr(), gids.size()*sizeof(global_ordinal_type));
+  outfile.write((const char*)uv.getRawPtr(), gids.size()*sizeof(scalar_type));
+  outfile.close();
+
+  if( !outfile || 0 != std::rename(tfile.c_str(), cfile.c_str()) ){
+    std::cout<<"Error writing checkpoint file "<<cfile<<std::endl;
+    exit(0);
+  }
+
+  if( 0 == mypid )
+    std::cout<<"Writing checkpoint : timestep :"<<step<<"  t = "<<time_<<std::endl;
+}
+
+template<class scalar_type>
+void ModelEvaluatorTPETRA<scalar_type>::read_checkpoint(Teuchos::RCP<vector_type> u, const int restart_procs)
+{
+  auto comm_ = Teuchos::DefaultComm<int>::getComm(); 
+  int mypid = comm_->getRank();
+  int numproc = comm_->getSize();
+
+  //cn each proc reads the files f with f%numproc == mypid; their global ids place the
+  //cn values, so the writing decomposition does not need to match this one
+
+  std::vector<global_ordinal_type> read_gid;
+  std::vector<scalar_type> read_u;
+  int step = -99;
+  int output_step = -99;
+  double time = -99.99;
+  double dt = -99.99;
+  int read_error = 0;
+
+  for( int f = mypid; f < restart_procs; f += numproc ){
+    const std::string cfile = checkpoint_file(f, restart_procs);
+    if( 0 == mypid )
+      std::cout<<"  Reading checkpoint; filename = "<<cfile<<std::endl;
+
+    char magic[8];
+    int header[6];
+    double theader[2];
+
+    std::ifstream infile(cfile.c_str(), std::ios::in | std::ios::binary);
+    infile.read(magic, sizeof(magic));
+    infile.read((char*)header, sizeof(header));
+    infile.read((char*)theader, sizeof(theader));
+    if( !infile || 0 != std::string(magic, 8).compare("TUSASCK1") 
+	|| restart_procs != header[0] || f != header[1] || numeqs_ != header[2] ){
+      std::cout<<"Error reading checkpoint file "<<cfile<<std::endl;
+      read_error = 1;
+      continue;
+    }
+    const int n = header[3];
+    const int offset = read_gid.size();
+    read_gid.resize(offset + n);
+    read_u.resize(offset + n);
+    infile.read((char*)(read_gid.data() + offset), n*sizeof(global_ordinal_type));
+    infile.read((char*)(read_u.data() + offset), n*sizeof(scalar_type));
+    if( !infile ){
+      std::cout<<"Error reading checkpoint file "<<cfile<<std::endl;
+      read_error = 1;
+      continue;
+    }
+    step = header[4];
+    output_step = header[5];
+    time = theader[0];
+    dt = theader[1];
+  }
+
+  //cn every proc has to leave together when any file could not be read
+  int gread_error = 0;
+  Teuchos::reduceAll<int, int>(*comm_, Teuchos::REDUCE_MAX, 1, &read_error, &gread_error);
+  if( 0 < gread_error ) exit(0);
+
+  //cn proc 0 always reads the first file
+  Teuchos::broadcast<int, int>(*comm_, 0, &step);
+  Teuchos::broadcast<int, int>(*comm_, 0, &output_step);
+  Teuchos::broadcast<int, double>(*comm_, 0, &time);
+  Teuchos::broadcast<int, double>(*comm_, 0, &dt);
+  if( 0 == mypid ){
+    std::cout<<"  Reading checkpoint step = "<<step<<" time = "<<time<<std::endl;
+    if( dt != dt_ ) std::cout<<"  Warning: checkpoint dt = "<<dt<<" differs from dt = "<<dt_<<std::endl;
+  }
+
+  //cn the owned ids of the writing run are one to one, so the export only moves values
+  const global_size_t numGlobalEntries = Teuchos::OrdinalTraits<Tpetra::global_size_t>::invalid();
+  const global_ordinal_type indexBase = 0;
+
+  Teuchos::ArrayView<global_ordinal_type> AV(read_gid);
+
+  Teuchos::RCP<const map_type> read_map = Teuchos::rcp(new map_type(numGlobalEntries,
+								    AV,
+								    indexBase,
+								    comm_
+								    ));
+  vector_type u_read(read_map);
+  {
+    const ArrayRCP<scalar_type> uv = u_read.get1dViewNonConst();
+    for( int i = 0; i < read_u.size(); i++ ) uv[i] = read_u[i];
+  }
+
+  export_type exporter(read_map, x_owned_map_);
+  u->doExport(u_read, exporter, Tpetra::INSERT);
+
+  this->start_time = time;
+  this->start_step = step;
+  time_=time;
+
+  //cn the results files of the same decomposition are appended to from the checkpointed
+  //cn output step; a new decomposition gets new files, as in restart_redistribute
+  if( restart_procs == numproc ){
+    create_output(true);
+    output_step_ = output_step;
+  }
+  else{
+    create_output();
+    output_step_ = 1;
+  }
+
+  if( 0 == mypid ){
+    std::cout<<"Restarting at time = "<<time<<" and step = "<<step<<std::endl<<std::endl;
+    std::cout<<"Exiting restart"<<std::endl<<std::endl;
+  }
+}
+
 template<class Scalar>
 void ModelEvaluatorTPETRA<Scalar>::postprocess()
 {
@@ -5437,6 +5437,50 @@ INI_FUNC(init_conc_farzadi_)
   return -1.;
 }
 }//namespace farzadi3d
+
+//cn compile time registry of residual/preconditioner functors for the fill kernels;
+//cn each functor is instantiated directly into the gauss point loop so the physics
+//cn can be inlined, test cases without an entry fall back to the pointer tables
+
+/// Fill kernel functor ids, selected by testcase in set_test_case().
+enum FILL_FUNCTOR {POINTER_FILL, HEAT_FILL, FARZADI_FILL};
+
+typedef RES_FUNC_TPETRA((*RESFUNC_TPETRA));
+typedef PRE_FUNC_TPETRA((*PREFUNC_TPETRA));
+
+/// Evaluates the physics through RESFUNC/PREFUNC pointer tables.
+struct pointer_functor{
+  pointer_functor(RESFUNC_TPETRA * rf, PREFUNC_TPETRA * pf) : rf_(rf), pf_(pf) {};
+  RESFUNC_TPETRA * rf_;
+  PREFUNC_TPETRA * pf_;
+  KOKKOS_INLINE_FUNCTION 
+  RES_FUNC_TPETRA(residual) const {return rf_[eqn_id](basis,i,dt_,t_theta_,time,eqn_id);};
+  KOKKOS_INLINE_FUNCTION 
+  PRE_FUNC_TPETRA(precon) const {return pf_[eqn_id](basis,i,j,dt_,t_theta_,eqn_id);};
+};
+
+/// Heat equation for every variable; "heat" and "heat2".
+struct heat_functor{
+  KOKKOS_INLINE_FUNCTION 
+  RES_FUNC_TPETRA(residual) const {return residual_heat_test_(basis,i,dt_,t_theta_,time,eqn_id);};
+  KOKKOS_INLINE_FUNCTION 
+  PRE_FUNC_TPETRA(precon) const {return prec_heat_test_(basis,i,j,dt_,t_theta_,eqn_id);};
+};
+
+/// Concentration (eqn 0) and phase (eqn 1); "farzadi".
+struct farzadi_functor{
+  KOKKOS_INLINE_FUNCTION 
+  RES_FUNC_TPETRA(residual) const {
+    return (0 == eqn_id) ? farzadi3d::residual_conc_farzadi_(basis,i,dt_,t_theta_,time,eqn_id)
+      : farzadi3d::residual_phase_farzadi_(basis,i,dt_,t_theta_,time,eqn_id);
+  };
+  KOKKOS_INLINE_FUNCTION 
+  PRE_FUNC_TPETRA(precon) const {
+    return (0 == eqn_id) ? farzadi3d::prec_conc_farzadi_(basis,i,j,dt_,t_theta_,eqn_id)
+      : farzadi3d::prec_phase_farzadi_(basis,i,j,dt_,t_theta_,eqn_id);
+  };
+};
+
 }//namespace tpetra
 
 
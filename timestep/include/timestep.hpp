@@ -31,6 +31,8 @@ public:
   virtual void finalize() = 0;
   /// Write solution to exodusII file.
   virtual void write_exodus() = 0;
+  /// Write a restart checkpoint after timestep step, when one is due.
+  virtual void checkpoint(const int step){};
   /// Return the timestep index for restart.
   virtual int get_start_step(){return start_step;};
   /// Return the timestep for restart.
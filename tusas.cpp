@@ -48,6 +48,7 @@
 #include "tusas.h"
 
 #include <sys/wait.h>
+#include <sys/stat.h>
 #if 0
 #include <unistd.h>
 #include <spawn.h>
@@ -115,6 +116,17 @@ int main(int argc, char *argv[])
     if(1 == numproc ){
       pfile = paramList.get<std::string> (TusasmeshNameString);
     }
+    else if( paramList.get<std::string> (TusasdecompmethodNameString) != "nemslice"
+	     && !paramList.get<bool> (TusaswritedecompNameString) ) {
+      //cn each proc reads its part of the global mesh below; no decomp files are written,
+      //cn decomp/ is only needed for the per proc results files and join
+      pfile = paramList.get<std::string> (TusasmeshNameString);
+      //cn a restart from a global or differently decomposed run may not have one yet
+      if( 0 == mypid ){
+	mkdir("decomp/", 0755);
+      }
+      Comm.Barrier();
+    }
     else {
       Comm.Barrier();
       dval = decomp(mypid, 
@@ -137,7 +149,24 @@ int main(int argc, char *argv[])
   {
     Teuchos::TimeMonitor TotalTimer(*ts_time_total); 
     in_mesh = new Mesh(mypid,numproc,false);
-    in_mesh->read_exodus(pfile.c_str());
+    const std::string decompmethod = paramList.get<std::string> (TusasdecompmethodNameString);
+    if( 1 != numproc && ( decompmethod == "linear" || decompmethod == "rcb" || decompmethod == "rib"
+			  || decompmethod == "hsfc" || decompmethod == "graph" ) ){
+      in_mesh->read_exodus_partial(pfile.c_str(), decompmethod);
+    }
+    else if( 1 != numproc && decompmethod != "nemslice" ){
+      if( 0 == mypid )
+	std::cout<<"Invalid decompmethod: "<<decompmethod<<"\n";
+      write_timers();
+      Kokkos::finalize();
+      return EXIT_FAILURE;
+    }
+    else {
+      in_mesh->read_exodus(pfile.c_str());
+    }
+    if( "none" != paramList.get<std::string> (TusasrenumberNameString) ){
+      in_mesh->renumber(paramList.get<std::string> (TusasrenumberNameString));
+    }
     in_mesh->set_global_file_name(paramList.get<std::string> (TusasmeshNameString) );
     
     double dt = paramList.get<double> (TusasdtNameString);
@@ -155,6 +184,9 @@ int main(int argc, char *argv[])
       std::cout<<"Invalid method."<<"\n"<<"\n";
       return EXIT_FAILURE;
     }
+
+    //cn the model evaluators may still renumber elements and copy connectivity in their constructors
+    if( paramList.get<bool> (TusascompactmeshNameString) ) in_mesh->compact();
     
     model->initialize();
     
@@ -177,6 +209,7 @@ int main(int argc, char *argv[])
 	
 	model->write_exodus();
       }
+      model->checkpoint(elapsedSteps);
     }
     
     model->finalize();
@@ -186,7 +219,8 @@ int main(int argc, char *argv[])
     if(1 != numproc ) {
       if(paramList.get<std::string> (TusasmethodNameString)  == "nemesis") join(mypid, numproc, 
 		    paramList.get<bool> (TusasskipdecompNameString));
-      if(paramList.get<std::string> (TusasmethodNameString)  == "tpetra") join(mypid, numproc, 
+      if(paramList.get<std::string> (TusasmethodNameString)  == "tpetra"
+	 && !paramList.get<bool> (TusasglobaloutputNameString)) join(mypid, numproc, 
 		    paramList.get<bool> (TusasskipdecompNameString));
     }
 